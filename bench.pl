@@ -0,0 +1,64 @@
+# Timings of the compiled projections, for `perl -Mblib bench.pl' after `make'.
+# Not part of `make test'.  Each line gives the milliseconds to project a
+# million points one at a time (gmt_forward) and all at once through the
+# array kernel of the projection (gmt_project), exact and with fast_trig.
+
+use PDL;
+use PDL::Graphics::PGPLOT::Map;
+use Time::HiRes qw(time);
+
+my $npts = 1000000;
+my @proj = (['Q0/1'], ['E-170/70/1'], ['G-30/40/1', -60, 0, 10, 70], ['S-30/40/1', -60, 0, 10, 70],
+            ['A-30/40/1', -60, 0, 10, 70], ['W0/1'], ['J0/1', -180, 180, -80, 80], ['T-30/1', -40, -20, 30, 60],
+            ['l-100/40/30/50/1:10000000', -130, -60, 20, 55], ['b-100/40/30/50/1:10000000', -130, -60, 20, 55],
+            ['C-30/40/1', -40, -20, 30, 50], ['M1', -180, 180, -80, 80], ['I0/1'], ['Y0/45/1']);
+
+sub ms {
+  my ($code) = @_;
+  my $t0 = time;
+  $code->();
+  return (time - $t0) * 1000;
+}
+
+my $f = sequence(double, $npts) / ($npts - 1);
+printf "%-28s %9s %9s %9s %9s\n", 'projection', 'point', 'array', 'fast pt', 'fast arr';
+foreach my $p (@proj) {
+  my ($jproj, @box) = @$p;
+  my ($w, $e, $s, $n) = @box ? @box : (-180, 180, -90, 90);
+  my $lon = $w + ($e - $w) * $f;
+  my $lat = $s + ($n - $s) * ($f * 7 - floor($f * 7));
+
+  my @t;
+  foreach my $fast (0, 1) {
+    PDL::Graphics::PGPLOT::Map::fast_trig ($fast);
+    PDL::Graphics::PGPLOT::Map::gmt_project ($lon->slice('0:9'), $lat->slice('0:9'), $jproj, @box);	# set up and cached
+    PDL::Graphics::PGPLOT::Map::project_lock ();
+    PDL::Graphics::PGPLOT::Map::_project_setup ($jproj, @box);
+    push @t, ms (sub { PDL::Graphics::PGPLOT::Map::gmt_forward ($lon, $lat) });
+    PDL::Graphics::PGPLOT::Map::project_unlock ();
+    push @t, ms (sub { PDL::Graphics::PGPLOT::Map::gmt_project ($lon, $lat, $jproj, @box) });
+  }
+  PDL::Graphics::PGPLOT::Map::fast_trig (0);
+  printf "%-28s %9.1f %9.1f %9.1f %9.1f\n", $jproj, @t;
+}
+
+# Full frame inverse: the lon/lat of every pixel of a 1920 by 1080 image of
+# the map, as for resampling a raster onto it, with 1 and 4 threads, and the
+# share of pixels whose inverse converged (0 for Winkel Tripel, whose GMT
+# inverse only solves on the outline of the map)
+my ($nx, $ny) = (1920, 1080);
+my $u = (sequence(double, 101) / 100)->dummy(1, 101);
+my $v = $u->transpose;
+printf "\n%-28s %9s %9s %9s\n", 'projection', 'grid', '4 thr', 'ok';
+foreach my $p (@proj, ['H0/1'], ['R0/1'], ['N0/1'], ['Kf0/1'], ['Ks0/1'], ['V0/1']) {
+  my ($jproj, @box) = @$p;
+  my ($w, $e, $s, $n) = @box ? @box : (-180, 180, -90, 90);
+  my ($bx, $by) = PDL::Graphics::PGPLOT::Map::gmt_project ($w + ($e - $w) * $u, $s + ($n - $s) * $v, $jproj, @box);
+  my $in = ($bx == $bx) & ($by == $by);	# not NaN
+  my ($xr, $yr) = ([$bx->where($in)->minmax, $nx], [$by->where($in)->minmax, $ny]);
+
+  my ($ok, @t);
+  push @t, ms (sub { (undef, undef, $ok) = PDL::Graphics::PGPLOT::Map::gmt_unproject_grid ($xr, $yr, $jproj, @box) });
+  push @t, ms (sub { PDL::Graphics::PGPLOT::Map::gmt_unproject_grid ($xr, $yr, $jproj, @box, {THREADS => 4}) });
+  printf "%-28s %9.1f %9.1f %9.3f\n", $jproj, @t, $ok->avg;
+}
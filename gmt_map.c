@@ -94,19 +94,33 @@
  *	GMT_clip_to_map :	Force polygon points to be inside map
  *	GMT_compact_line :	Remove redundant pen movements
  *	GMT_geo_to_xy :		Generic lon/lat to x/y
+ *	GMT_geo_to_xy_array :	Same for arrays of points
  *	GMT_geo_to_xy_line :	Same for polygons
+ *	GMT_geo_to_xy_line_xy :	Same, for points already projected by GMT_geo_to_xy_array
  *	GMT_geoz_to_xy :	Generic 3-D lon/lat/z to x/y
  *	GMT_grd_forward :	Forward map-transform grid matrix from lon/lat to x/y
  *	GMT_grd_inverse :	Inversly transform grid matrix from x/y to lon/lat
  *	GMT_grdproject_init :	Initialize parameters for grid transformations
  *	GMT_great_circle_dist :	Returns great circle distance in degrees
+ *	GMT_great_circle_dist_array :	Same, and azimuths, for pairs of points
+ *	GMT_great_circle_dist_one :	Same from one point to many
+ *	GMT_great_circle_dist_matrix :	Same from every point of one set to every point of another
  *	GMT_map_outside :	Generic function determines if we're outside map boundary
  *	GMT_map_path :		Return latpat or GMT_lonpath
  *	GMT_map_setup :		Initialize map projection
+ *	GMT_project_mutex_init :	Makes the projection lock one a thread may take again
+ *	GMT_setup_cache_get :	Restores the map projection of an earlier GMT_map_setup
+ *	GMT_setup_cache_put :	Remembers the map projection just set up
+ *	GMT_setup_cache_stats :	Returns hits, misses and entries of the setup cache
+ *	GMT_setup_cache_flush :	Empties the setup cache
+ *	GMT_simplify_line :	Douglas-Peucker line reduction to a tolerance
  *	GMT_pen_status :	Determines if pen is up or down
  *	GMT_project3D :		Convert lon/lat/z to xx/yy/zz
  *	GMT_2D_to_3D :		Convert xyz to xy for entire array
  *	GMT_xy_to_geo :		Generic inverse x/y to lon/lat projection
+ *	GMT_xy_to_geo_array :	Same for arrays of points
+ *	GMT_forward_array :	GMT_forward for arrays of points
+ *	GMT_inverse_array :	GMT_inverse for arrays of points, with a convergence mask
  *	GMT_xyz_to_xy :		Generic xyz to xy projection
  *
  * Internal GMT Functions include:
@@ -141,6 +155,8 @@
  *	GMT_lambeq :			Lambert azimuthal equal area projection
  *	GMT_latpath :			Return path between 2 points of equal latitide
  *	GMT_lonpath :			Return path between 2 points of equal longitude
+ *	GMT_straight_latpath :		Same, straight in lon/lat
+ *	GMT_straight_lonpath :		Same, straight in lon/lat
  *	GMT_radial_crossing :		Determine map crossing in the Lambert azimuthal equal area projection
  *	GMT_left_boundary :		Return left boundary in x-inches
  *	GMT_linearxy :			Linear xy projection
@@ -200,12 +216,24 @@
 #include "gmt_map.h"
 
 #define HALF_DBL_MAX (DBL_MAX/2.0)
+#define GMT_GC_BLOCK 256	/* Columns per block in GMT_great_circle_dist_matrix, 8 kb of trig */
 
 BOOLEAN GMT_convert_latitudes = FALSE;	/* TRUE if using spherical code with authalic/conformal latitudes */
+struct GMT_SETUP_STATE *GMT_setup_cache[HASH_SIZE];	/* Map setups by GMT_hash of their key, or NULL */
+long GMT_setup_cache_hits = 0, GMT_setup_cache_misses = 0;
+#ifdef GMT_THREADS
+pthread_mutex_t GMT_setup_cache_mutex = PTHREAD_MUTEX_INITIALIZER;	/* Guards the setup cache and its counts */
+pthread_mutex_t GMT_project_mutex;	/* Guards the map projection, see GMT_project_lock */
+pthread_once_t GMT_project_once = PTHREAD_ONCE_INIT;
+#endif
 
 /* ANSI-C Prototypes for functions internal to gmt_map.c */
 
 BOOLEAN GMT_quickconic (void);
+BOOLEAN GMT_setup_cache_key (char *key, char *jarg, double west, double east, double south, double north);
+int GMT_setup_cache_slot (char *key);
+int GMT_straight_lonpath (double lon, double lat1, double lat2, double **x, double **y, struct GMT_ARENA *A);
+int GMT_straight_latpath (double lat, double lon1, double lon2, double **x, double **y, struct GMT_ARENA *A);
 BOOLEAN GMT_quicktm (double lon0, double limit);
 void GMT_vpolar(double lon0);
 void GMT_vmerc(double cmerid);
@@ -332,6 +360,48 @@ int GMT_radial_clip(double *lon, double *lat, int np, double **x, double **y);
 int GMT_wesn_overlap(double lon0, double lat0, double lon1, double lat1);		/*	Checks if two wesn regions overlap	*/
 int GMT_rect_overlap(double lon0, double lat0, double lon1, double lat1);		/*	Checks if two xy regions overlap	*/
 int GMT_radial_overlap(double lon0, double lat0, double lon1, double lat1);		/*	Currently a dummy routine	*/
+double GMT_lon_wrap(double lon);		/*	Branch free step of the -180/180 wrap, for the array kernels	*/
+PFV GMT_batch_forward(void);		/*	Returns the array kernel for GMT_forward, if any	*/
+PFV GMT_batch_inverse(void);		/*	Returns the array kernel for GMT_inverse, if any	*/
+void GMT_merc_sph_array(double *lon, double *lat, double *x, double *y, int n);	/*	Array kernels, see GMT_geo_to_xy_array	*/
+void GMT_imerc_sph_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_cyleq_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_icyleq_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_cyleqdist_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_icyleqdist_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_miller_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_imiller_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_azeqdist_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_ortho_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_sinusoidal_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_isinusoidal_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_set_proj_block(void);		/*	Fills GMT_proj_block for the current projection	*/
+void GMT_tm_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_itm_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_tm_sph_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_lamb_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_lamb_sph_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_albers_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_albers_sph_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_cassini_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_icassini_array(double *x, double *y, double *lon, double *lat, int n);
+void GMT_cassini_sph_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_fast_sincos(double x, double *s, double *c);	/*	Polynomial sincos, asin and acos for GMT_fast_trig	*/
+double GMT_fast_asin(double x);
+double GMT_fast_acos(double x);
+void GMT_set_fast_trig(void);		/*	Swaps in the fast forward functions if GMT_fast_trig	*/
+void GMT_azeqdist_fast(double lon, double lat, double *x, double *y);
+void GMT_ortho_fast(double lon, double lat, double *x, double *y);
+void GMT_stereo1_fast(double lon, double lat, double *x, double *y);
+void GMT_lambeq_fast(double lon, double lat, double *x, double *y);
+void GMT_mollweide_fast(double lon, double lat, double *x, double *y);
+void GMT_azeqdist_fast_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_ortho_fast_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_stereo1_fast_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_lambeq_fast_array(double *lon, double *lat, double *x, double *y, int n);
+void GMT_mollweide_fast_array(double *lon, double *lat, double *x, double *y, int n);
+int GMT_ilamb_warm(double *x, double *y, double *lon, double *lat, char *ok, int n);
+int GMT_ialbers_warm(double *x, double *y, double *lon, double *lat, char *ok, int n);
 
 int GMT_map_init_linear(void);
 int GMT_map_init_polar(void);
@@ -750,6 +820,9 @@ void GMT_map_setup (double west, double east, double south, double north)
 			break;
 	}
 
+	GMT_set_proj_block ();
+	if (GMT_fast_trig) GMT_set_fast_trig ();
+
 	project_info.i_x_scale = (project_info.x_scale != 0.0) ? 1.0 / project_info.x_scale : 1.0;
 	project_info.i_y_scale = (project_info.y_scale != 0.0) ? 1.0 / project_info.y_scale : 1.0;
 	project_info.i_z_scale = (project_info.z_scale != 0.0) ? 1.0 / project_info.z_scale : 1.0;
@@ -787,6 +860,185 @@ void GMT_map_setup (double west, double east, double south, double north)
 	if (!project_info.y_off_supplied && gmtdefs.overlay) gmtdefs.y_origin = 0.0;
 }
 
+/*
+ * The setup cache.  GMT_map_getproject and GMT_map_setup are redone for
+ * every map, even when it is the one just drawn.  A cache of the state they
+ * leave behind, keyed by the -J argument, the region and the settings read
+ * along the way, lets the same map be set up again with a few struct copies.
+ * A key goes in one of GMT_SETUP_PROBE slots from its GMT_hash, replacing
+ * the one used least recently when they are all taken.
+ */
+
+BOOLEAN GMT_setup_cache_key (char *key, char *jarg, double west, double east, double south, double north)
+{
+	/* Writes the cache key of a map setup into key.  Returns FALSE if the
+	 * -J argument is too long to cache */
+
+	if (strlen (jarg) > GMT_SETUP_KEY_LEN - 128) return (FALSE);
+	sprintf (key, "%s/%.17g/%.17g/%.17g/%.17g/%d/%d/%d", jarg, west, east, south, north, (int)project_info.region, gmtdefs.ellipsoid, (int)GMT_fast_trig);
+	return (TRUE);
+}
+
+int GMT_setup_cache_slot (char *key)
+{
+	/* Returns the slot holding key, or failing that the slot to put it in */
+
+	int i, h, slot = -1;
+
+	for (i = 0; i < GMT_SETUP_PROBE; i++) {
+		h = (GMT_hash (key) + i) % HASH_SIZE;
+		if (!GMT_setup_cache[h]) {
+			if (slot < 0 || GMT_setup_cache[slot]) slot = h;
+		}
+		else if (!strcmp (GMT_setup_cache[h]->key, key))
+			return (h);
+		else if (slot < 0 || (GMT_setup_cache[slot] && GMT_setup_cache[h]->used < GMT_setup_cache[slot]->used))
+			slot = h;
+	}
+	return (slot);
+}
+
+BOOLEAN GMT_setup_cache_get (char *key, char *jarg, double west, double east, double south, double north)
+{
+	/* Restores the map projection set up earlier for the same -J argument
+	 * and region, with the current -R...r setting, ellipsoid and fast trig.
+	 * Returns FALSE (and counts a miss) if there is none; the caller then
+	 * does GMT_map_getproject and GMT_map_setup and GMT_setup_cache_put
+	 * with key, GMT_SETUP_KEY_LEN chars of its own.  The key is taken now,
+	 * as some projections change the ellipsoid */
+
+	struct GMT_SETUP_STATE *S;
+
+	key[0] = '\0';
+	if (!GMT_setup_cache_key (key, jarg, west, east, south, north)) {
+		GMT_setup_cache_lock ();
+		GMT_setup_cache_misses++;
+		GMT_setup_cache_unlock ();
+		return (FALSE);
+	}
+	GMT_setup_cache_lock ();
+	if (!(S = GMT_setup_cache[GMT_setup_cache_slot (key)]) || strcmp (S->key, key)) {
+		GMT_setup_cache_misses++;
+		GMT_setup_cache_unlock ();
+		return (FALSE);
+	}
+	key[0] = '\0';
+	S->used = GMT_setup_cache_hits + GMT_setup_cache_misses;
+
+	project_info = S->project_info;
+	frame_info = S->frame_info;
+	gmtdefs = S->gmtdefs;
+	z_project = S->z_project;
+	GMT_proj_block = S->proj_block;
+	GMT_forward = S->forward;		GMT_inverse = S->inverse;
+	GMT_x_forward = S->x_forward;		GMT_x_inverse = S->x_inverse;
+	GMT_y_forward = S->y_forward;		GMT_y_inverse = S->y_inverse;
+	GMT_z_forward = S->z_forward;		GMT_z_inverse = S->z_inverse;
+	GMT_outside = S->outside;		GMT_crossing = S->crossing;
+	GMT_overlap = S->overlap;		GMT_map_clip = S->map_clip;
+	GMT_left_edge = S->left_edge;		GMT_right_edge = S->right_edge;
+	GMT_wrap_around_check = S->wrap_around_check;
+	GMT_map_jump = S->map_jump;
+	GMT_will_it_wrap = S->will_it_wrap;
+	GMT_this_point_wraps = S->this_point_wraps;
+	GMT_get_crossings = S->get_crossings;
+	GMT_truncate = S->truncate;
+	GMT_world_map = S->world_map;		GMT_world_map_tm = S->world_map_tm;
+	GMT_meridian_straight = S->meridian_straight;
+	GMT_parallel_straight = S->parallel_straight;
+	GMT_convert_latitudes = S->convert_latitudes;
+	GMT_corner = S->corner;
+	GMT_map_width = S->map_width;		GMT_map_height = S->map_height;
+	GMT_half_map_size = S->half_map_size;	GMT_half_map_height = S->half_map_height;
+	GMT_setup_cache_hits++;
+	GMT_setup_cache_unlock ();
+	GMT_lat_swap_init ();	/* A few products of the ellipsoid; its tables are checked when used */
+	return (TRUE);
+}
+
+void GMT_setup_cache_put (char *key)
+{
+	/* Remembers the map projection just set up by GMT_map_getproject and
+	 * GMT_map_setup, under the key GMT_setup_cache_get gave when it missed */
+
+	int h;
+	struct GMT_SETUP_STATE *S;
+
+	if (!key[0]) return;
+	GMT_setup_cache_lock ();
+	h = GMT_setup_cache_slot (key);
+	if (!GMT_setup_cache[h]) GMT_setup_cache[h] = (struct GMT_SETUP_STATE *) GMT_memory (VNULL, (size_t)1, sizeof (struct GMT_SETUP_STATE), "GMT_setup_cache_put");
+	S = GMT_setup_cache[h];
+
+	strcpy (S->key, key);
+	S->used = GMT_setup_cache_hits + GMT_setup_cache_misses;
+	S->project_info = project_info;
+	S->frame_info = frame_info;
+	S->gmtdefs = gmtdefs;
+	S->z_project = z_project;
+	S->proj_block = GMT_proj_block;
+	S->forward = GMT_forward;		S->inverse = GMT_inverse;
+	S->x_forward = GMT_x_forward;		S->x_inverse = GMT_x_inverse;
+	S->y_forward = GMT_y_forward;		S->y_inverse = GMT_y_inverse;
+	S->z_forward = GMT_z_forward;		S->z_inverse = GMT_z_inverse;
+	S->outside = GMT_outside;		S->crossing = GMT_crossing;
+	S->overlap = GMT_overlap;		S->map_clip = GMT_map_clip;
+	S->left_edge = GMT_left_edge;		S->right_edge = GMT_right_edge;
+	S->wrap_around_check = GMT_wrap_around_check;
+	S->map_jump = GMT_map_jump;
+	S->will_it_wrap = GMT_will_it_wrap;
+	S->this_point_wraps = GMT_this_point_wraps;
+	S->get_crossings = GMT_get_crossings;
+	S->truncate = GMT_truncate;
+	S->world_map = GMT_world_map;		S->world_map_tm = GMT_world_map_tm;
+	S->meridian_straight = GMT_meridian_straight;
+	S->parallel_straight = GMT_parallel_straight;
+	S->convert_latitudes = GMT_convert_latitudes;
+	S->corner = GMT_corner;
+	S->map_width = GMT_map_width;		S->map_height = GMT_map_height;
+	S->half_map_size = GMT_half_map_size;	S->half_map_height = GMT_half_map_height;
+	GMT_setup_cache_unlock ();
+}
+
+void GMT_setup_cache_stats (long stats[3])
+{
+	int h;
+
+	GMT_setup_cache_lock ();
+	stats[0] = GMT_setup_cache_hits;
+	stats[1] = GMT_setup_cache_misses;
+	for (h = 0, stats[2] = 0; h < HASH_SIZE; h++) if (GMT_setup_cache[h]) stats[2]++;
+	GMT_setup_cache_unlock ();
+}
+
+void GMT_setup_cache_flush (void)
+{
+	int h;
+
+	GMT_setup_cache_lock ();
+	for (h = 0; h < HASH_SIZE; h++) {
+		if (!GMT_setup_cache[h]) continue;
+		GMT_free ((void *)GMT_setup_cache[h]);
+		GMT_setup_cache[h] = (struct GMT_SETUP_STATE *)NULL;
+	}
+	GMT_setup_cache_unlock ();
+}
+
+#ifdef GMT_THREADS
+void GMT_project_mutex_init (void)
+{
+	/* Run once through GMT_project_lock.  The lock is recursive so that a
+	 * caller holding it across setup and use may call functions that take it */
+
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init (&attr);
+	pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init (&GMT_project_mutex, &attr);
+	pthread_mutexattr_destroy (&attr);
+}
+#endif
+
 void GMT_init_three_D (void) {
 	int i, easy;
 	double tilt_angle, x, y, x0, x1, x2, y0, y1, y2, zmin, zmax;
@@ -1068,6 +1320,902 @@ void GMT_xy_to_geo (double *lon, double *lat, double x, double y)
 	(*GMT_inverse) (lon, lat, x, y);
 }
 
+/*
+ * Batch versions of GMT_geo_to_xy and GMT_xy_to_geo.  The projection is
+ * looked up once per call, and the common projections have array kernels
+ * that keep the projection parameters in locals and do no per-point
+ * branching on global state, so the loops can be vectorized.  All others
+ * fall back to calling GMT_forward/GMT_inverse for each point.  The scalar
+ * functions remain the reference; the kernels give the same results.
+ */
+
+void GMT_geo_to_xy_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* Converts n lon/lat to x/y using the current projection */
+	int i;
+	double xs, ys, x0, y0;
+
+	GMT_forward_array (lon, lat, x, y, n);
+
+	xs = project_info.x_scale;	x0 = project_info.x0;
+	ys = project_info.y_scale;	y0 = project_info.y0;
+	for (i = 0; i < n; i++) {
+		x[i] = x[i] * xs + x0;
+		y[i] = y[i] * ys + y0;
+	}
+}
+
+void GMT_xy_to_geo_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* Converts n x/y to lon/lat using the current projection.  x and y
+	 * may be the same arrays as lon and lat, but are left alone otherwise */
+	int i;
+	double ixs, iys, x0, y0;
+	PFV batch;
+
+	ixs = project_info.i_x_scale;	x0 = project_info.x0;
+	iys = project_info.i_y_scale;	y0 = project_info.y0;
+	for (i = 0; i < n; i++) {
+		lon[i] = (x[i] - x0) * ixs;
+		lat[i] = (y[i] - y0) * iys;
+	}
+
+	if ((batch = GMT_batch_inverse ()))
+		(*batch) (lon, lat, lon, lat, n);
+	else
+		for (i = 0; i < n; i++) (*GMT_inverse) (&lon[i], &lat[i], lon[i], lat[i]);
+}
+
+void GMT_forward_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_forward for n lon/lat, to x/y in projection units (not inches).
+	 * x and y must not be the same arrays as lon and lat */
+	int i;
+	PFV batch;
+
+	if ((batch = GMT_batch_forward ()))
+		(*batch) (lon, lat, x, y, n);
+	else
+		for (i = 0; i < n; i++) (*GMT_forward) (lon[i], lat[i], &x[i], &y[i]);
+}
+
+int GMT_inverse_array (double *x, double *y, double *lon, double *lat, char *ok, int n)
+{
+	/* GMT_inverse for n x/y in projection units (not inches).  ok[i], if ok
+	 * is not NULL, is set to 0 where point i did not converge or came out
+	 * NaN or infinite, and 1 elsewhere.  Returns the number of such points.
+	 * The Lambert and Albers inverses start each point from the solution
+	 * of the one before, so consecutive points along a row or a path should
+	 * be near each other.  GMT_iwinkel also iterates, but only solves for
+	 * points on the perimeter, so Winkel Tripel points all come out NaN and
+	 * not ok.  x and y may be the same arrays as lon and lat */
+	int i, n_bad = 0;
+	PFV batch;
+
+	if (GMT_inverse == (PFI)GMT_iwinkel) {
+		for (i = 0; i < n; i++) {
+			lon[i] = lat[i] = GMT_d_NaN;
+			if (ok) ok[i] = 0;
+		}
+		n_bad = n;
+	}
+	else if (GMT_inverse == (PFI)GMT_ilamb)
+		n_bad = GMT_ilamb_warm (x, y, lon, lat, ok, n);
+	else if (GMT_inverse == (PFI)GMT_ialbers)
+		n_bad = GMT_ialbers_warm (x, y, lon, lat, ok, n);
+	else {
+		if ((batch = GMT_batch_inverse ()))
+			(*batch) (x, y, lon, lat, n);
+		else
+			for (i = 0; i < n; i++) (*GMT_inverse) (&lon[i], &lat[i], x[i], y[i]);
+		for (i = 0; i < n; i++) {
+			if (!GMT_is_dnan (lon[i] - lon[i] + lat[i] - lat[i])) {	/* Finite */
+				if (ok) ok[i] = 1;
+				continue;
+			}
+			if (ok) ok[i] = 0;
+			n_bad++;
+		}
+	}
+	return (n_bad);
+}
+
+double GMT_lon_wrap (double lon)
+{
+	/* One step of the while loops in the scalar projections, without
+	 * branching.  Applied twice it gives the same -180 <= lon <= 180 for
+	 * any lon within 900 degrees of the central meridian */
+	double up, down;
+
+	up = (lon < -180.0) ? 360.0 : 0.0;
+	down = (lon > 180.0) ? 360.0 : 0.0;
+	return (lon + up - down);
+}
+
+PFV GMT_batch_forward (void)
+{
+	/* Returns the array kernel for the current forward projection, or NULL */
+
+	if (GMT_forward == (PFI)GMT_cyleqdist) return ((PFV)GMT_cyleqdist_array);
+	if (GMT_forward == (PFI)GMT_azeqdist_fast) return ((PFV)GMT_azeqdist_fast_array);
+	if (GMT_forward == (PFI)GMT_ortho_fast) return ((PFV)GMT_ortho_fast_array);
+	if (GMT_forward == (PFI)GMT_stereo1_fast) return ((PFV)GMT_stereo1_fast_array);
+	if (GMT_forward == (PFI)GMT_lambeq_fast) return ((PFV)GMT_lambeq_fast_array);
+	if (GMT_forward == (PFI)GMT_mollweide_fast) return ((PFV)GMT_mollweide_fast_array);
+	if (GMT_forward == (PFI)GMT_miller) return ((PFV)GMT_miller_array);
+	if (GMT_forward == (PFI)GMT_azeqdist) return ((PFV)GMT_azeqdist_array);
+	if (GMT_forward == (PFI)GMT_ortho) return ((PFV)GMT_ortho_array);
+	if (GMT_forward == (PFI)GMT_tm) return ((PFV)GMT_tm_array);
+	if (GMT_forward == (PFI)GMT_lamb) return ((PFV)GMT_lamb_array);
+	if (GMT_forward == (PFI)GMT_albers && fabs (GMT_proj_block.e) >= GMT_CONV_LIMIT) return ((PFV)GMT_albers_array);
+	if (GMT_forward == (PFI)GMT_cassini) return ((PFV)GMT_cassini_array);
+	if (GMT_forward == (PFI)GMT_cassini_sph) return ((PFV)GMT_cassini_sph_array);
+	if (GMT_forward == (PFI)GMT_merc_sph) return ((PFV)GMT_merc_sph_array);
+	if (GMT_forward == (PFI)GMT_sinusoidal) return ((PFV)GMT_sinusoidal_array);
+	if (GMT_forward == (PFI)GMT_lamb_sph) return ((PFV)GMT_lamb_sph_array);
+	if (GMT_forward == (PFI)GMT_albers_sph) return ((PFV)GMT_albers_sph_array);
+	if (GMT_convert_latitudes) return ((PFV)NULL);	/* Rest need GMT_lat_swap */
+	if (GMT_forward == (PFI)GMT_cyleq) return ((PFV)GMT_cyleq_array);
+	if (GMT_forward == (PFI)GMT_tm_sph) return ((PFV)GMT_tm_sph_array);
+	return ((PFV)NULL);
+}
+
+PFV GMT_batch_inverse (void)
+{
+	/* Returns the array kernel for the current inverse projection, or NULL */
+
+	if (GMT_inverse == (PFI)GMT_icyleqdist) return ((PFV)GMT_icyleqdist_array);
+	if (GMT_inverse == (PFI)GMT_imiller) return ((PFV)GMT_imiller_array);
+	if (GMT_inverse == (PFI)GMT_itm) return ((PFV)GMT_itm_array);
+	if (GMT_inverse == (PFI)GMT_icassini) return ((PFV)GMT_icassini_array);
+	if (GMT_inverse == (PFI)GMT_imerc_sph) return ((PFV)GMT_imerc_sph_array);
+	if (GMT_inverse == (PFI)GMT_isinusoidal) return ((PFV)GMT_isinusoidal_array);
+	if (GMT_convert_latitudes) return ((PFV)NULL);
+	if (GMT_inverse == (PFI)GMT_icyleq) return ((PFV)GMT_icyleq_array);
+	return ((PFV)NULL);
+}
+
+void GMT_merc_sph_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_merc_sph for n points */
+	int i;
+	double cm = project_info.central_meridian, mx = project_info.m_mx, m = project_info.m_m, l, t, u;
+
+	if (GMT_convert_latitudes) {	/* Conformal latitudes first */
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2C, GMT_fast_trig);
+		lat = y;
+	}
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm));
+		t = lat[i];
+		u = (fabs (t) < 90.0) ? m * d_log (tan (M_PI_4 + 0.5 * D2R * t)) : copysign (DBL_MAX, t);
+		x[i] = mx * l;
+		y[i] = u;
+	}
+}
+
+void GMT_imerc_sph_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_imerc_sph for n points */
+	int i;
+	double cm = project_info.central_meridian, imx = project_info.m_imx, im = project_info.m_im, u, v;
+
+	for (i = 0; i < n; i++) {
+		u = x[i] * imx + cm;
+		v = atan (sinh (y[i] * im)) * R2D;
+		lon[i] = u;
+		lat[i] = v;
+	}
+	if (GMT_convert_latitudes) GMT_lat_swap_array (lat, lat, n, GMT_LATSWAP_C2G, FALSE);
+}
+
+void GMT_cyleq_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_cyleq for n points, spherical only */
+	int i;
+	double cm = project_info.central_meridian, rx = project_info.y_rx, ry = project_info.y_ry, l, u;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm));
+		u = ry * sind (lat[i]);
+		x[i] = l * rx;
+		y[i] = u;
+	}
+}
+
+void GMT_icyleq_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_icyleq for n points, spherical only */
+	int i;
+	double cm = project_info.central_meridian, irx = project_info.y_i_rx, iry = project_info.y_i_ry, u, v;
+
+	for (i = 0; i < n; i++) {
+		u = (x[i] * irx) + cm;
+		v = R2D * d_asin (y[i] * iry);
+		lon[i] = u;
+		lat[i] = v;
+	}
+}
+
+void GMT_cyleqdist_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_cyleqdist for n points */
+	int i;
+	double cm = project_info.central_meridian, r = project_info.q_r, l, u;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm));
+		u = lat[i] * r;
+		x[i] = l * r;
+		y[i] = u;
+	}
+}
+
+void GMT_icyleqdist_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_icyleqdist for n points */
+	int i;
+	double cm = project_info.central_meridian, ir = project_info.q_ir, u, v;
+
+	for (i = 0; i < n; i++) {
+		u = x[i] * ir + cm;
+		v = y[i] * ir;
+		lon[i] = u;
+		lat[i] = v;
+	}
+}
+
+void GMT_miller_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_miller for n points */
+	int i;
+	double cm = project_info.central_meridian, jx = project_info.j_x, jy = project_info.j_y, l, u;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm));
+		u = jy * d_log (tan (M_PI_4 + 0.4 * lat[i] * D2R));
+		x[i] = l * jx;
+		y[i] = u;
+	}
+}
+
+void GMT_imiller_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_imiller for n points */
+	int i;
+	double cm = project_info.central_meridian, ijx = project_info.j_ix, ijy = project_info.j_iy, u, v;
+
+	for (i = 0; i < n; i++) {
+		u = x[i] * ijx + cm;
+		v = 2.5 * R2D * atan (exp (y[i] * ijy)) - 112.5;
+		lon[i] = u;
+		lat[i] = v;
+	}
+}
+
+void GMT_azeqdist_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_azeqdist for n points.  Points at the center or antipode go to 0,0 as there */
+	int i;
+	double cm = project_info.central_meridian, sinp = project_info.sinp, cosp = project_info.cosp;
+	double R = project_info.EQ_RAD, l, t, k, cc, c, clat, slon, clon, slat;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm)) * D2R;
+		t = lat[i] * D2R;
+		slat = sin (t);	clat = cos (t);
+		slon = sin (l);	clon = cos (l);
+		t = clat * clon;
+		cc = sinp * slat + cosp * t;
+		c = d_acos (cc);
+		k = (fabs (cc) >= 1.0) ? 0.0 : R * c / sin (c);
+		x[i] = k * clat * slon;
+		y[i] = k * (cosp * slat - sinp * t);
+	}
+}
+
+void GMT_ortho_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_ortho for n points */
+	int i;
+	double cm = project_info.central_meridian, sinp = project_info.sinp, cosp = project_info.cosp;
+	double R = project_info.EQ_RAD, l, t, sin_lat, cos_lat, sin_lon, cos_lon;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm)) * D2R;
+		t = lat[i] * D2R;
+		sin_lat = sin (t);	cos_lat = cos (t);
+		sin_lon = sin (l);	cos_lon = cos (l);
+		x[i] = R * cos_lat * sin_lon;
+		y[i] = R * (cosp * sin_lat - sinp * cos_lat * cos_lon);
+	}
+}
+
+void GMT_sinusoidal_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_sinusoidal for n points */
+	int i;
+	double cm = project_info.central_meridian, R = project_info.EQ_RAD, l, t;
+
+	if (GMT_convert_latitudes) {	/* Authalic latitudes first */
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2A, GMT_fast_trig);
+		lat = y;
+	}
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm)) * D2R;
+		t = lat[i] * D2R;
+		x[i] = R * l * cos (t);
+		y[i] = R * t;
+	}
+}
+
+void GMT_isinusoidal_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_isinusoidal for n points */
+	int i;
+	double cm = project_info.central_meridian, R = project_info.EQ_RAD, iR = project_info.i_EQ_RAD, u, v;
+
+	for (i = 0; i < n; i++) {
+		v = y[i] * iR;
+		u = ((fabs (fabs (v) - M_PI) < GMT_CONV_LIMIT) ? 0.0 : R2D * x[i] / (R * cos (v))) + cm;
+		lon[i] = u;
+		lat[i] = v * R2D;
+	}
+	if (GMT_convert_latitudes) GMT_lat_swap_array (lat, lat, n, GMT_LATSWAP_A2G, FALSE);
+}
+
+void GMT_set_proj_block (void)
+{
+	/* Copies the constants of the projection just set up into GMT_proj_block.
+	 * The kernels below take a local copy of it, so they read nothing global
+	 * per point and the compiler need not assume x/y stores change them */
+	struct GMT_PROJ_BLOCK *P = &GMT_proj_block;
+
+	P->cm = project_info.central_meridian;
+	P->R = project_info.EQ_RAD;
+	P->k0 = gmtdefs.map_scale_factor;
+	P->e = project_info.ECC;
+	P->e2 = project_info.ECC2;
+	P->half_e = project_info.half_ECC;
+	P->i_half_e = project_info.i_half_ECC;
+	P->one_m_e2 = project_info.one_m_ECC2;
+	P->i_one_m_e2 = project_info.i_one_m_ECC2;
+
+	switch (project_info.projection) {
+		case LAMBERT:
+			P->n = project_info.l_N;	P->i_n = project_info.l_i_N;	P->nr = project_info.l_Nr;
+			P->F = project_info.l_rF;	P->rho0 = project_info.l_rho0;
+			break;
+		case ALBERS:
+			P->n = project_info.a_n;	P->i_n = project_info.a_i_n;
+			P->C = project_info.a_C;	P->rho0 = project_info.a_rho0;
+			break;
+		case TM:
+		case UTM:
+			P->ep2 = project_info.t_e2;	P->lat0 = project_info.t_lat0;	P->M0 = project_info.t_M0;
+			P->c[0] = project_info.t_c1;	P->c[1] = project_info.t_c2;	P->c[2] = project_info.t_c3;	P->c[3] = project_info.t_c4;
+			P->i[0] = project_info.t_i1;	P->i[1] = project_info.t_i2;	P->i[2] = project_info.t_i3;
+			P->i[3] = project_info.t_i4;	P->i[4] = project_info.t_i5;
+			break;
+		case CASSINI:
+			P->lat0 = project_info.c_p;	P->M0 = project_info.c_M0;
+			P->c[0] = project_info.c_c1;	P->c[1] = project_info.c_c2;	P->c[2] = project_info.c_c3;	P->c[3] = project_info.c_c4;
+			P->i[0] = project_info.c_i1;	P->i[1] = project_info.c_i2;	P->i[2] = project_info.c_i3;
+			P->i[3] = project_info.c_i4;	P->i[4] = project_info.c_i5;
+			break;
+	}
+}
+
+void GMT_tm_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_tm for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double N, T, T2, C, A, M, dlon, tan_lat, A2, A3, A5, t, t2, s, c, s2, c2, xx, yy, up, pole;
+
+	pole = P.k0 * (P.R * P.c[0] * M_PI_2);
+	for (i = 0; i < n; i++) {
+		t = lat[i] * D2R;
+		t2 = 2.0 * t;
+		sincos (t, &s, &c);
+		sincos (t2, &s2, &c2);
+		tan_lat = s / c;
+		M = P.R * (P.c[0] * t + s2 * (P.c[1] + c2 * (P.c[2] + c2 * P.c[3])));
+		dlon = lon[i] - P.cm;
+		up = (fabs (dlon) > 360.0) ? dlon + copysign (360.0, -dlon) : dlon;
+		dlon = (fabs (up) > 180.0) ? copysign (360.0 - fabs (up), -up) : up;
+		N = P.R / d_sqrt (1.0 - P.e2 * s * s);
+		T = tan_lat * tan_lat;
+		T2 = T * T;
+		C = P.ep2 * c * c;
+		A = dlon * D2R * c;
+		A2 = A * A;	A3 = A2 * A;	A5 = A3 * A2;
+		xx = P.k0 * N * (A + (1.0 - T + C) * (A3 * 0.16666666666666666667)
+			+ (5.0 - 18.0 * T + T2 + 72.0 * C - 58.0 * P.ep2) * (A5 * 0.00833333333333333333));
+		A3 *= A;	A5 *= A;
+		yy = P.k0 * (M - P.M0 + N * tan_lat * (0.5 * A2 + (5.0 - T + 9.0 * C + 4.0 * C * C) * (A3 * 0.04166666666666666667)
+			+ (61.0 - 58.0 * T + T2 + 600.0 * C - 330.0 * P.ep2) * (A5 * 0.00138888888888888889)));
+		t = (fabs (fabs (lat[i]) - 90.0) < GMT_CONV_LIMIT) ? 0.0 : xx;
+		t2 = (fabs (fabs (lat[i]) - 90.0) < GMT_CONV_LIMIT) ? pole : yy;
+		x[i] = t;
+		y[i] = t2;
+	}
+}
+
+void GMT_itm_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_itm for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double M, mu, u2, s, c, phi1, C1, C12, T1, T12, tmp, tmp2, N1, R_1, D, D2, D3, D5, tan_phi1, cp2, u, v;
+
+	for (i = 0; i < n; i++) {
+		M = y[i] / P.k0 + P.M0;
+		mu = M * P.i[0];
+		u2 = 2.0 * mu;
+		sincos (u2, &s, &c);
+		phi1 = mu + s * (P.i[1] + c * (P.i[2] + c * (P.i[3] + c * P.i[4])));
+		sincos (phi1, &s, &c);
+		tan_phi1 = s / c;
+		cp2 = c * c;
+		C1 = P.ep2 * cp2;
+		C12 = C1 * C1;
+		T1 = tan_phi1 * tan_phi1;
+		T12 = T1 * T1;
+		tmp = 1.0 - P.e2 * (1.0 - cp2);
+		tmp2 = d_sqrt (tmp);
+		N1 = P.R / tmp2;
+		R_1 = P.R * P.one_m_e2 / (tmp * tmp2);
+		D = x[i] / (N1 * P.k0);
+		D2 = D * D;	D3 = D2 * D;	D5 = D3 * D2;
+		u = P.cm + R2D * (D - (1.0 + 2.0 * T1 + C1) * (D3 * 0.16666666666666666667)
+			+ (5.0 - 2.0 * C1 + 28.0 * T1 - 3.0 * C12 + 8.0 * P.ep2 + 24.0 * T12)
+			* (D5 * 0.00833333333333333333)) / c;
+		D3 *= D;	D5 *= D;
+		v = phi1 - (N1 * tan_phi1 / R_1) * (0.5 * D2 -
+			(5.0 + 3.0 * T1 + 10.0 * C1 - 4.0 * C12 - 9.0 * P.ep2) * (D3 * 0.04166666666666666667)
+			+ (61.0 + 90.0 * T1 + 298 * C1 + 45.0 * T12 - 252.0 * P.ep2 - 3.0 * C12) * (D5 * 0.00138888888888888889));
+		lon[i] = u;
+		lat[i] = v * R2D;
+	}
+}
+
+void GMT_tm_sph_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_tm_sph for n points, without conformal latitudes */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double dlon, r, b, clat, slat, clon, slon, xx, yy, up, t, edge;
+
+	r = P.R * P.k0;
+	edge = -r * P.lat0;
+	for (i = 0; i < n; i++) {
+		dlon = lon[i] - P.cm;
+		up = (fabs (dlon) > 360.0) ? dlon + copysign (360.0, -dlon) : dlon;
+		dlon = (fabs (up) > 180.0) ? copysign (360.0 - fabs (up), -up) : up;
+		t = lat[i] * D2R;
+		dlon *= D2R;
+		sincos (t, &slat, &clat);
+		sincos (dlon, &slon, &clon);
+		b = clat * slon;
+		xx = r * atanh (b);
+		yy = atan2 (slat, (clat * clon)) - P.lat0;
+		up = (yy < -M_PI_2) ? yy + TWO_PI : yy;
+		yy = r * up;
+		up = (fabs (b) >= 1.0 || fabs (lat[i]) > 90.0) ? copysign (1.0e100, dlon) : xx;	/* Transverse "pole" or invalid latitude */
+		t = (fabs (lat[i]) > 90.0) ? 0.0 : ((fabs (b) >= 1.0) ? edge : yy);
+		x[i] = up;
+		y[i] = t;
+	}
+}
+
+void GMT_lamb_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_lamb for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double rho, theta, hold1, hold2, hold3, es, s, c, l, t;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - P.cm));
+		t = lat[i] * D2R;
+		es = P.e * sin (t);
+		hold2 = pow (((1.0 - es) / (1.0 + es)), P.half_e);
+		hold3 = tan (M_PI_4 - 0.5 * t);
+		hold1 = pow (hold3 / hold2, P.n);
+		hold1 = (fabs (hold3) < GMT_CONV_LIMIT) ? 0.0 : hold1;
+		rho = P.F * hold1;
+		theta = P.nr * l;
+		sincos (theta, &s, &c);
+		x[i] = rho * s;
+		y[i] = P.rho0 - rho * c;
+	}
+}
+
+void GMT_lamb_sph_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_lamb_sph for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double rho, theta, A, t, s, c, l;
+
+	if (GMT_convert_latitudes) {	/* Conformal latitudes first */
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2C, GMT_fast_trig);
+		lat = y;
+	}
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - P.cm));
+		t = tan (M_PI_4 - 0.5 * (lat[i] * D2R));
+		A = pow (t, P.n);
+		A = (fabs (t) < GMT_CONV_LIMIT) ? 0.0 : A;
+		rho = P.F * A;
+		theta = P.nr * l;
+		sincos (theta, &s, &c);
+		x[i] = rho * s;
+		y[i] = P.rho0 - rho * c;
+	}
+}
+
+void GMT_albers_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_albers for n points, ellipsoid only (e > 0) */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double s, c, q, theta, rho, r, l, t;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - P.cm)) * D2R;
+		t = lat[i] * D2R;
+		s = sin (t);
+		r = P.e * s;
+		q = P.one_m_e2 * (s / (1.0 - P.e2 * s * s) - P.i_half_e * log ((1.0 - r) / (1.0 + r)));
+		theta = P.n * l;
+		rho = P.R * sqrt (P.C - P.n * q) * P.i_n;
+		sincos (theta, &s, &c);
+		x[i] = rho * s;
+		y[i] = P.rho0 - rho * c;
+	}
+}
+
+void GMT_albers_sph_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_albers_sph for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double s, c, theta, rho, l, t;
+
+	if (GMT_convert_latitudes) {	/* Authalic latitudes first */
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2A, GMT_fast_trig);
+		lat = y;
+	}
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - P.cm)) * D2R;
+		t = lat[i] * D2R;
+		theta = P.n * l;
+		rho = P.R * sqrt (P.C - 2.0 * P.n * sin (t)) * P.i_n;
+		sincos (theta, &s, &c);
+		x[i] = rho * s;
+		y[i] = P.rho0 - rho * c;
+	}
+}
+
+void GMT_cassini_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_cassini for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double t, t2, tany, N, T, A, C, M, s, c, s2, c2, A2, A3, l, xx, yy;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - P.cm)) * D2R;
+		t = lat[i] * D2R;
+		t2 = 2.0 * t;
+		sincos (t, &s, &c);
+		sincos (t2, &s2, &c2);
+		tany = s / c;
+		N = P.R / sqrt (1.0 - P.e2 * s * s);
+		T = tany * tany;
+		A = l * c;
+		A2 = A * A;
+		A3 = A2 * A;
+		C = P.e2 * c * c * P.i_one_m_e2;
+		M = P.R * (P.c[0] * t + s2 * (P.c[1] + c2 * (P.c[2] + c2 * P.c[3])));
+		xx = N * (A - T * A3 / 6.0 - (8.0 - T + 8 * C) * T * A3 * A2 / 120.0);
+		yy = M - P.M0 + N * tany * (0.5 * A2 + (5.0 - T + 6.0 * C) * A2 * A2 / 24.0);
+		t = (fabs (lat[i]) < GMT_CONV_LIMIT) ? P.R * l : xx;	/* Quick when lat is zero */
+		t2 = (fabs (lat[i]) < GMT_CONV_LIMIT) ? -P.M0 : yy;
+		x[i] = t;
+		y[i] = t2;
+	}
+}
+
+void GMT_icassini_array (double *x, double *y, double *lon, double *lat, int n)
+{
+	/* GMT_icassini for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double M1, u1, u2, s, c, phi1, tany, T1, N1, R_1, D, S2, D2, D3, u, v;
+
+	for (i = 0; i < n; i++) {
+		M1 = P.M0 + y[i];
+		u1 = M1 * P.i[0];
+		u2 = 2.0 * u1;
+		sincos (u2, &s, &c);
+		phi1 = u1 + s * (P.i[1] + c * (P.i[2] + c * (P.i[3] + c * P.i[4])));
+		sincos (phi1, &s, &c);
+		tany = s / c;
+		T1 = tany * tany;
+		S2 = 1.0 - P.e2 * s * s;
+		N1 = P.R / sqrt (S2);
+		R_1 = P.R * P.one_m_e2 / pow (S2, 1.5);
+		D = x[i] / N1;
+		D2 = D * D;
+		D3 = D2 * D;
+		v = R2D * (phi1 - (N1 * tany / R_1) * (0.5 * D2 - (1.0 + 3.0 * T1) * D2 * D2 / 24.0));
+		u = P.cm + R2D * (D - T1 * D3 / 3.0 + (1.0 + 3.0 * T1) * T1 * D3 * D2 / 15.0) / c;
+		D = (fabs (fabs (phi1) - M_PI_2) < GMT_CONV_LIMIT) ? copysign (M_PI_2, phi1) : v;	/* At the pole, as GMT_icassini */
+		u = (fabs (fabs (phi1) - M_PI_2) < GMT_CONV_LIMIT) ? P.cm : u;
+		lon[i] = u;
+		lat[i] = D;
+	}
+}
+
+void GMT_cassini_sph_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_cassini_sph for n points */
+	int i;
+	struct GMT_PROJ_BLOCK P = GMT_proj_block;
+	double slon, clon, clat, tlat, slat, l, t;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - P.cm)) * D2R;
+		t = lat[i] * D2R;
+		sincos (l, &slon, &clon);
+		sincos (t, &slat, &clat);
+		tlat = slat / clat;
+		x[i] = P.R * d_asin (clat * slon);
+		y[i] = P.R * (atan (tlat / clon) - P.lat0);
+	}
+}
+
+/*
+ * Fast trigonometry.  With GMT_fast_trig set before GMT_map_setup, the
+ * azimuthal equidistant, orthographic, stereographic (oblique, spherical),
+ * Lambert azimuthal and Mollweide forward projections use the polynomial
+ * functions below instead of libm.  Their maximum absolute errors are
+ * 2e-14 (GMT_fast_sincos, |x| < 1000) and 2e-15 (GMT_fast_asin/acos).
+ * Auxiliary latitudes are interpolated from GMT_lat_swap_table.  Projected
+ * points differ from the exact ones by less than 1e-11 of the radius (under
+ * 0.1 mm), except for Mollweide within 0.1 degree of a pole: there the Newton
+ * iteration of both converges slowly and they stop up to 1e-7 of the radius
+ * apart, neither nearer the true point.
+ *
+ * Must not be compiled with -ffast-math, which would undo the rounding trick
+ * in GMT_fast_sincos.  This also holds for the array kernels: they vectorize
+ * their arithmetic loops, but their libm calls stay scalar.
+ */
+
+void GMT_fast_sincos (double x, double *s, double *c)
+{
+	/* x is reduced to |r| <= pi/4 with pi/2 split in two parts, and the
+	 * quadrant is applied with selects, not branches */
+	int q;
+	double k, r, z, ps, pc, t, u;
+
+	k = x * M_2_PI + 6755399441055744.0;	/* 1.5 * 2^52, so k rounds to the nearest integer */
+	k -= 6755399441055744.0;
+	q = (int)k;
+	r = (x - k * 1.57079632673412561417e+00) - k * 6.07710050650619224932e-11;
+	z = r * r;
+	ps = r + r * z * (-0.16666666666663896 + z * (0.0083333333310789577 + z * (-0.00019841266916092773
+		+ z * (2.7555990622247341e-06 + z * -2.4805607656268721e-08))));
+	pc = 1.0 - 0.5 * z + z * z * (0.041666666666931619 + z * (-0.0013888888926235606 + z * (2.4801603514369547e-05
+		+ z * (-2.7559810539883241e-07 + z * 2.0925355218939216e-09))));
+	t = (q & 1) ? pc : ps;
+	u = (q & 1) ? ps : pc;
+	*s = (q & 2) ? -t : t;
+	*c = ((q + 1) & 2) ? -u : u;
+}
+
+double GMT_fast_asin (double x)
+{
+	/* asin (t) = t + t^3 P(t^2) for |t| <= 0.5, else via asin (sqrt ((1-t)/2)).  |x| > 1 is treated as 1, as d_asin */
+	double a, z, t, p;
+
+	a = fabs (x);
+	a = (a > 1.0) ? 1.0 : a;
+	z = (a > 0.5) ? 0.5 * (1.0 - a) : a * a;
+	t = (a > 0.5) ? sqrt (z) : a;
+	p = t + t * z * (0.16666666666666935 + z * (0.074999999996181996 + z * (0.04464285770902484
+		+ z * (0.030381911525426197 + z * (0.02237315180379762 + z * (0.017335224197514435
+		+ z * (0.014157750074657131 + z * (0.010200223267970557 + z * (0.015734010798907353
+		+ z * (-0.0073408493957732059 + z * 0.028268721464429325))))))))));
+	p = (a > 0.5) ? M_PI_2 - 2.0 * p : p;
+	return (copysign (p, x));
+}
+
+double GMT_fast_acos (double x)
+{
+	/* As GMT_fast_asin, without the loss of accuracy of pi/2 - asin near |x| = 1 */
+	double a, z, t, p, r;
+
+	a = fabs (x);
+	a = (a > 1.0) ? 1.0 : a;
+	z = (a > 0.5) ? 0.5 * (1.0 - a) : a * a;
+	t = (a > 0.5) ? sqrt (z) : a;
+	p = t + t * z * (0.16666666666666935 + z * (0.074999999996181996 + z * (0.04464285770902484
+		+ z * (0.030381911525426197 + z * (0.02237315180379762 + z * (0.017335224197514435
+		+ z * (0.014157750074657131 + z * (0.010200223267970557 + z * (0.015734010798907353
+		+ z * (-0.0073408493957732059 + z * 0.028268721464429325))))))))));
+	r = (a > 0.5) ? 2.0 * p : M_PI_2 - p;
+	return ((x < 0.0) ? M_PI - r : r);
+}
+
+void GMT_set_fast_trig (void)
+{
+	/* Replaces the forward function GMT_map_init_* chose by its fast version, if any */
+
+	if (GMT_forward == (PFI)GMT_azeqdist) GMT_forward = (PFI)GMT_azeqdist_fast;
+	else if (GMT_forward == (PFI)GMT_ortho) GMT_forward = (PFI)GMT_ortho_fast;
+	else if (GMT_forward == (PFI)GMT_stereo1_sph) GMT_forward = (PFI)GMT_stereo1_fast;
+	else if (GMT_forward == (PFI)GMT_lambeq) GMT_forward = (PFI)GMT_lambeq_fast;
+	else if (GMT_forward == (PFI)GMT_mollweide) GMT_forward = (PFI)GMT_mollweide_fast;
+
+	if (GMT_convert_latitudes) {	/* Make the lookup tables now rather than in a batch */
+		GMT_lat_swap_table (GMT_LATSWAP_G2C);
+		GMT_lat_swap_table (GMT_LATSWAP_G2A);
+		GMT_lat_swap_table (GMT_LATSWAP_C2G);
+		GMT_lat_swap_table (GMT_LATSWAP_A2G);
+	}
+}
+
+void GMT_azeqdist_fast (double lon, double lat, double *x, double *y)
+{
+	GMT_azeqdist_fast_array (&lon, &lat, x, y, 1);
+}
+
+void GMT_ortho_fast (double lon, double lat, double *x, double *y)
+{
+	GMT_ortho_fast_array (&lon, &lat, x, y, 1);
+}
+
+void GMT_stereo1_fast (double lon, double lat, double *x, double *y)
+{
+	GMT_stereo1_fast_array (&lon, &lat, x, y, 1);
+}
+
+void GMT_lambeq_fast (double lon, double lat, double *x, double *y)
+{
+	GMT_lambeq_fast_array (&lon, &lat, x, y, 1);
+}
+
+void GMT_mollweide_fast (double lon, double lat, double *x, double *y)
+{
+	GMT_mollweide_fast_array (&lon, &lat, x, y, 1);
+}
+
+void GMT_azeqdist_fast_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_azeqdist_array with fast trig */
+	int i;
+	double cm = project_info.central_meridian, sinp = project_info.sinp, cosp = project_info.cosp;
+	double R = project_info.EQ_RAD, l, t, k, cc, c, clat, slon, clon, slat, sc, dummy;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm)) * D2R;
+		GMT_fast_sincos (lat[i] * D2R, &slat, &clat);
+		GMT_fast_sincos (l, &slon, &clon);
+		t = clat * clon;
+		cc = sinp * slat + cosp * t;
+		c = GMT_fast_acos (cc);
+		GMT_fast_sincos (c, &sc, &dummy);
+		k = (fabs (cc) >= 1.0) ? 0.0 : R * c / sc;
+		x[i] = k * clat * slon;
+		y[i] = k * (cosp * slat - sinp * t);
+	}
+}
+
+void GMT_ortho_fast_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_ortho_array with fast trig */
+	int i;
+	double cm = project_info.central_meridian, sinp = project_info.sinp, cosp = project_info.cosp;
+	double R = project_info.EQ_RAD, l, sin_lat, cos_lat, sin_lon, cos_lon;
+
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm)) * D2R;
+		GMT_fast_sincos (lat[i] * D2R, &sin_lat, &cos_lat);
+		GMT_fast_sincos (l, &sin_lon, &cos_lon);
+		x[i] = R * cos_lat * sin_lon;
+		y[i] = R * (cosp * sin_lat - sinp * cos_lat * cos_lon);
+	}
+}
+
+void GMT_stereo1_fast_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_stereo1_sph for n points with fast trig */
+	int i;
+	double cm = project_info.central_meridian, sinp = project_info.sinp, cosp = project_info.cosp;
+	double s_c = project_info.s_c, sin_dlon, cos_dlon, s, c, cc, A, t, Dx = 1.0, Dy = 1.0;
+
+	if (GMT_convert_latitudes) {	/* Conformal latitudes from the lookup table */
+		Dx = project_info.Dx, Dy = project_info.Dy;
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2C, TRUE);
+		lat = y;
+	}
+	for (i = 0; i < n; i++) {
+		t = lat[i];
+		GMT_fast_sincos (D2R * (lon[i] - cm), &sin_dlon, &cos_dlon);
+		GMT_fast_sincos (t * D2R, &s, &c);
+		cc = c * cos_dlon;
+		A = s_c / (1.0 + sinp * s + cosp * cc);
+		x[i] = A * c * sin_dlon * Dx;
+		y[i] = A * (cosp * s - sinp * cc) * Dy;
+	}
+}
+
+void GMT_lambeq_fast_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_lambeq for n points with fast trig */
+	int i;
+	double cm = project_info.central_meridian, sinp = project_info.sinp, cosp = project_info.cosp;
+	double R = project_info.EQ_RAD, l, k, tmp, sin_lat, cos_lat, sin_lon, cos_lon, c, u, v, t, Dx = 1.0, Dy = 1.0;
+
+	if (GMT_convert_latitudes) {	/* Authalic latitudes from the lookup table */
+		Dx = project_info.Dx, Dy = project_info.Dy;
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2A, TRUE);
+		lat = y;
+	}
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm)) * D2R;
+		t = lat[i];
+		GMT_fast_sincos (t * D2R, &sin_lat, &cos_lat);
+		GMT_fast_sincos (l, &sin_lon, &cos_lon);
+		c = cos_lat * cos_lon;
+		tmp = 1.0 + sinp * sin_lat + cosp * c;
+		k = R * d_sqrt (2.0 / tmp);
+		u = k * cos_lat * sin_lon * Dx;
+		v = k * (cosp * sin_lat - sinp * c) * Dy;
+		x[i] = (tmp > 0.0) ? u : -DBL_MAX;
+		y[i] = (tmp > 0.0) ? v : -DBL_MAX;
+	}
+}
+
+void GMT_mollweide_fast_array (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_mollweide for n points with fast trig */
+	int i, j;
+	double cm = project_info.central_meridian, wx = project_info.w_x, wy = project_info.w_y;
+	double l, t, phi, delta, psin_lat, c, s, *a = lat;
+
+	if (GMT_convert_latitudes) {	/* Authalic latitudes from the lookup table */
+		GMT_lat_swap_array (lat, y, n, GMT_LATSWAP_G2A, TRUE);
+		a = y;
+	}
+	for (i = 0; i < n; i++) {
+		l = GMT_lon_wrap (GMT_lon_wrap (lon[i] - cm));
+		t = a[i] * D2R;
+		GMT_fast_sincos (t, &s, &c);
+		psin_lat = M_PI * s;
+		phi = t;
+		j = 0;
+		do {
+			j++;
+			GMT_fast_sincos (phi, &s, &c);
+			delta = -(phi + s - psin_lat) / (1.0 + c);
+			phi += delta;
+		}
+		while (fabs (delta) > GMT_CONV_LIMIT && j < 100);
+		GMT_fast_sincos (0.5 * phi, &s, &c);
+		x[i] = wx * l * c;
+		y[i] = wy * s;
+		if (fabs (fabs (lat[i]) - 90.0) < GMT_CONV_LIMIT) {	/* Special case */
+			x[i] = 0.0;
+			y[i] = copysign (wy, lat[i]);
+		}
+	}
+}
+
 void GMT_geoz_to_xy (double x, double y, double z, double *x_out, double *y_out)
 {	/* Map-projects xy first, the projects xyz onto xy plane */
 	double x0, y0, z0;
@@ -2072,6 +3220,45 @@ void GMT_lamb_sph (double lon, double lat, double *x, double *y)
 	*y = project_info.l_rho0 - rho * c;
 }
 
+int GMT_ilamb_warm (double *x, double *y, double *lon, double *lat, char *ok, int n)
+{
+	/* GMT_ilamb for n points, for GMT_inverse_array.  The iteration for the
+	 * latitude starts from the spherical value plus the correction the
+	 * previous point needed, which is nearly the same for a neighbour, and so
+	 * takes one or two steps instead of four or five */
+	int i, k, n_bad = 0;
+	double theta, rho, t, tphi, tphi0, phi, delta, dy, r, u, warm = 0.0;
+
+	for (i = 0; i < n; i++) {
+		dy = project_info.l_rho0 - y[i];
+		theta = atan (x[i] / dy);
+		u = theta * project_info.l_i_Nr + project_info.central_meridian;
+		rho = copysign (hypot (x[i], dy), project_info.l_N);
+		t = pow ((rho * project_info.l_i_rF), project_info.l_i_N);
+		tphi0 = M_PI_2 - 2.0 * atan (t);
+		tphi = phi = tphi0 + warm;
+		delta = 1.0;
+		for (k = 0; k < 100 && delta > GMT_CONV_LIMIT; k++) {
+			r = project_info.ECC * sin (tphi);
+			phi = M_PI_2 - 2.0 * atan (t * pow ((1.0 - r) / (1.0 + r), project_info.half_ECC));
+			delta = fabs (fabs (tphi) - fabs (phi));
+			tphi = phi;
+		}
+		lon[i] = u;
+		lat[i] = phi * R2D;
+		if (delta > GMT_CONV_LIMIT || GMT_is_dnan (u - u + phi - phi)) {	/* Failed; next one starts cold */
+			warm = 0.0;
+			n_bad++;
+			if (ok) ok[i] = 0;
+		}
+		else {
+			warm = phi - tphi0;
+			if (ok) ok[i] = 1;
+		}
+	}
+	return (n_bad);
+}
+
 void GMT_ilamb_sph (double *lon, double *lat, double x, double y)
 {
 	double theta, rho, t;
@@ -4501,6 +5688,57 @@ void GMT_albers_sph (double lon, double lat, double *x, double *y)
 	*y = project_info.a_rho0 - rho * c;
 }
 
+int GMT_ialbers_warm (double *x, double *y, double *lon, double *lat, char *ok, int n)
+{
+	/* GMT_ialbers for n points, for GMT_inverse_array.  Newton's method
+	 * starts from the authalic latitude plus the correction the previous
+	 * point needed, as in GMT_ilamb_warm */
+	int i, n_iter, n_bad = 0;
+	BOOLEAN bad;
+	double theta, rho, q, phi, phi0, phi1, s, c, s2, ex_1, delta, r, u, v, dy, warm = 0.0;
+
+	for (i = 0; i < n; i++) {
+		dy = project_info.a_rho0 - y[i];
+		theta = (project_info.a_n < 0.0) ? d_atan2 (-x[i], -dy) : d_atan2 (x[i], dy);
+		rho = hypot (x[i], dy);
+		q = (project_info.a_C - rho * rho * project_info.a_n2ir2) * project_info.a_i_n;
+		u = project_info.central_meridian + R2D * theta * project_info.a_i_n;
+
+		delta = 0.0;
+		if (fabs (fabs (q) - project_info.a_test) < GMT_CONV_LIMIT)
+			v = copysign (90.0, q);
+		else {
+			phi1 = d_asin (0.5 * q);
+			phi = phi1 + warm;
+			if (fabs (phi) >= M_PI_2) phi = phi1;	/* Too close to a pole to jump there */
+			n_iter = 0;
+			do {
+				phi0 = phi;
+				sincos (phi0, &s, &c);
+				r = project_info.ECC * s;
+				s2 = s * s;
+				ex_1 = 1.0 - project_info.ECC2 * s2;
+				phi = phi0 + 0.5 * ex_1 * ex_1 * ((q * project_info.i_one_m_ECC2) - s / ex_1
+					+ project_info.i_half_ECC * log ((1 - r) / (1.0 + r))) / c;
+				delta = fabs (phi - phi0);
+				n_iter++;
+			}
+			while (delta > GMT_CONV_LIMIT && n_iter < 100);
+			v = R2D * phi;
+			warm = phi - phi1;
+		}
+		lon[i] = u;
+		lat[i] = v;
+		bad = (delta > GMT_CONV_LIMIT || GMT_is_dnan (u - u + v - v));
+		if (bad) {	/* Failed; next one starts cold */
+			warm = 0.0;
+			n_bad++;
+		}
+		if (ok) ok[i] = !bad;
+	}
+	return (n_bad);
+}
+
 void GMT_ialbers_sph (double *lon, double *lat, double x, double y)
 {
 	/* Convert Spherical Albers x/y to lon/lat */
@@ -5437,6 +6675,94 @@ double GMT_great_circle_dist(double lon1, double lat1, double lon2, double lat2)
 	return( c * R2D);
 }
 
+/* Great circle distances and azimuths for many points.  They use Vincenty's
+ * atan2 form, which unlike the cosine rule above stays accurate for points
+ * very close together or nearly antipodal.  Distances are in degrees, and
+ * azimuths in degrees clockwise from north, 0-360, of the direction from the
+ * first point to the second (0 for coincident points).  az may be NULL.
+ */
+
+void GMT_great_circle_dist_array (double *lon1, double *lat1, double *lon2, double *lat2, double *dist, double *az, int n)
+{
+	/* dist[i] (and az[i]) from point lon1[i]/lat1[i] to lon2[i]/lat2[i] */
+	int i;
+	double s1, c1, s2, c2, sl, cl, a, b, d, z;
+
+	for (i = 0; i < n; i++) {
+		sincos (lat1[i] * D2R, &s1, &c1);
+		sincos (lat2[i] * D2R, &s2, &c2);
+		sincos ((lon2[i] - lon1[i]) * D2R, &sl, &cl);
+		a = c2 * sl;
+		b = c1 * s2 - s1 * c2 * cl;
+		d = atan2 (sqrt (a * a + b * b), s1 * s2 + c1 * c2 * cl) * R2D;
+		z = atan2 (a, b) * R2D;
+		dist[i] = d;
+		if (az) az[i] = (z < 0.0) ? z + 360.0 : z;
+	}
+}
+
+void GMT_great_circle_dist_one (double lon0, double lat0, double *lon, double *lat, double *dist, double *az, int n)
+{
+	/* dist[i] (and az[i]) from the point lon0/lat0 to lon[i]/lat[i] */
+	int i;
+	double s1, c1, s2, c2, sl, cl, a, b, d, z;
+
+	sincos (lat0 * D2R, &s1, &c1);
+	for (i = 0; i < n; i++) {
+		sincos (lat[i] * D2R, &s2, &c2);
+		sincos ((lon[i] - lon0) * D2R, &sl, &cl);
+		a = c2 * sl;
+		b = c1 * s2 - s1 * c2 * cl;
+		d = atan2 (sqrt (a * a + b * b), s1 * s2 + c1 * c2 * cl) * R2D;
+		z = atan2 (a, b) * R2D;
+		dist[i] = d;
+		if (az) az[i] = (z < 0.0) ? z + 360.0 : z;
+	}
+}
+
+void GMT_great_circle_dist_matrix (double *lon1, double *lat1, int n1, double *lon2, double *lat2, int n2, double *dist, double *az)
+{
+	/* dist[i*n2+j] (and az[i*n2+j]) from point i of the first set to point j
+	 * of the second.  The sines and cosines of every point are computed once,
+	 * with the difference in longitude from the sum formulas, and the second
+	 * set is done GMT_GC_BLOCK points at a time so its trig stays in cache
+	 * for all points of the first */
+	int i, j, j0, j1;
+	size_t k;
+	double *t1, *t2, sl, cl, a, b, d, z;
+
+	t1 = (double *) GMT_memory (VNULL, (size_t)(4 * n1), sizeof (double), "GMT_great_circle_dist_matrix");
+	t2 = (double *) GMT_memory (VNULL, (size_t)(4 * n2), sizeof (double), "GMT_great_circle_dist_matrix");
+	for (i = 0; i < n1; i++) {
+		sincos (lat1[i] * D2R, &t1[4*i], &t1[4*i+1]);
+		sincos (lon1[i] * D2R, &t1[4*i+2], &t1[4*i+3]);
+	}
+	for (j = 0; j < n2; j++) {
+		sincos (lat2[j] * D2R, &t2[4*j], &t2[4*j+1]);
+		sincos (lon2[j] * D2R, &t2[4*j+2], &t2[4*j+3]);
+	}
+
+	for (j0 = 0; j0 < n2; j0 = j1) {
+		j1 = MIN (j0 + GMT_GC_BLOCK, n2);
+		for (i = 0; i < n1; i++) {
+			double s1 = t1[4*i], c1 = t1[4*i+1], sp = t1[4*i+2], cp = t1[4*i+3];
+			k = (size_t)i * (size_t)n2;
+			for (j = j0; j < j1; j++) {
+				sl = t2[4*j+2] * cp - t2[4*j+3] * sp;
+				cl = t2[4*j+3] * cp + t2[4*j+2] * sp;
+				a = t2[4*j+1] * sl;
+				b = c1 * t2[4*j] - s1 * t2[4*j+1] * cl;
+				d = atan2 (sqrt (a * a + b * b), s1 * t2[4*j] + c1 * t2[4*j+1] * cl) * R2D;
+				z = atan2 (a, b) * R2D;
+				dist[k+j] = d;
+				if (az) az[k+j] = (z < 0.0) ? z + 360.0 : z;
+			}
+		}
+	}
+	GMT_free ((void *)t1);
+	GMT_free ((void *)t2);
+}
+
 /* The *_outside rutines returns the status of the current point.  Status is
  * the sum of x_status and y_status. x_status may be
  *	0	w < lon < e
@@ -5972,8 +7298,9 @@ int GMT_eqdist_crossing (double lon1, double lat1, double lon2, double lat2, dou
 
 /*  Routines to add pieces of parallels or meridians */
 
-int GMT_graticule_path (double **x, double **y, int dir, double w, double e, double s, double n)
-{	/* Returns the path of a graticule (box of meridians and parallels) */
+int GMT_graticule_path (double **x, double **y, int dir, BOOLEAN straight, double w, double e, double s, double n, struct GMT_ARENA *A)
+{	/* Returns the path of a graticule (box of meridians and parallels), in memory from A.
+	 * With straight it is the box in lon/lat, whatever the map */
 	int np;
 	double *xx, *yy;
 	double px0, px1, px2, px3;
@@ -5987,9 +7314,9 @@ int GMT_graticule_path (double **x, double **y, int dir, double w, double e, dou
 	
 	/* Close graticule from point 0 through point 4 */
 	
-	if (RECT_GRATICULE) {	/* Simple rectangle in this projection */
-		xx = (double *) GMT_memory (VNULL, 4, sizeof (double), GMT_program);
-		yy = (double *) GMT_memory (VNULL, 4, sizeof (double), GMT_program);
+	if (straight || RECT_GRATICULE) {	/* Simple rectangle in this projection */
+		xx = (double *) GMT_arena_alloc (A, 4, sizeof (double));
+		yy = (double *) GMT_arena_alloc (A, 4, sizeof (double));
 		xx[0] = px0;	xx[1] = px1;	xx[2] = px2;	xx[3] = px3;
 		yy[0] = yy[1] = s;	yy[2] = yy[3] = n;
 		np = 4;
@@ -5999,31 +7326,31 @@ int GMT_graticule_path (double **x, double **y, int dir, double w, double e, dou
 		int add;
 		size_t n_alloc;
 					
-		np = n_alloc = add = GMT_latpath (s, px0, px1, &xx, &yy);	/* South */
-		add = GMT_lonpath (px1, s, n, &xtmp, &ytmp);	/* east (or west if dir == -1) */
+		np = n_alloc = add = GMT_latpath (s, px0, px1, &xx, &yy, A);	/* South */
+		add = GMT_lonpath (px1, s, n, &xtmp, &ytmp, A);	/* east (or west if dir == -1) */
+		xx = (double *)GMT_arena_grow (A, (void *)xx, n_alloc, n_alloc + add, sizeof (double));
+		yy = (double *)GMT_arena_grow (A, (void *)yy, n_alloc, n_alloc + add, sizeof (double));
 		n_alloc += add;
-		xx = (double *)GMT_memory ((void *)xx, n_alloc, sizeof (double), GMT_program);
-		yy = (double *)GMT_memory ((void *)yy, n_alloc, sizeof (double), GMT_program);
 		memcpy ((void *)&xx[np], (void *)xtmp, (size_t)(add * sizeof (double)));
 		memcpy ((void *)&yy[np], (void *)ytmp, (size_t)(add * sizeof (double)));
 		np += add;
-		GMT_free ((void *)xtmp);	GMT_free ((void *)ytmp);
-		add = GMT_latpath (n, px2, px3, &xtmp, &ytmp);	/* North */
+		GMT_arena_release (A, (void *)xtmp);	GMT_arena_release (A, (void *)ytmp);
+		add = GMT_latpath (n, px2, px3, &xtmp, &ytmp, A);	/* North */
+		xx = (double *)GMT_arena_grow (A, (void *)xx, n_alloc, n_alloc + add, sizeof (double));
+		yy = (double *)GMT_arena_grow (A, (void *)yy, n_alloc, n_alloc + add, sizeof (double));
 		n_alloc += add;
-		xx = (double *)GMT_memory ((void *)xx, n_alloc, sizeof (double), GMT_program);
-		yy = (double *)GMT_memory ((void *)yy, n_alloc, sizeof (double), GMT_program);
 		memcpy ((void *)&xx[np], (void *)xtmp, (size_t)(add * sizeof (double)));
 		memcpy ((void *)&yy[np], (void *)ytmp, (size_t)(add * sizeof (double)));
 		np += add;
-		GMT_free ((void *)xtmp);	GMT_free ((void *)ytmp);
-		add = GMT_lonpath (px3, n, s, &xtmp, &ytmp);	/* west */
+		GMT_arena_release (A, (void *)xtmp);	GMT_arena_release (A, (void *)ytmp);
+		add = GMT_lonpath (px3, n, s, &xtmp, &ytmp, A);	/* west */
+		xx = (double *)GMT_arena_grow (A, (void *)xx, n_alloc, n_alloc + add, sizeof (double));
+		yy = (double *)GMT_arena_grow (A, (void *)yy, n_alloc, n_alloc + add, sizeof (double));
 		n_alloc += add;
-		xx = (double *)GMT_memory ((void *)xx, n_alloc, sizeof (double), GMT_program);
-		yy = (double *)GMT_memory ((void *)yy, n_alloc, sizeof (double), GMT_program);
 		memcpy ((void *)&xx[np], (void *)xtmp, (size_t)(add * sizeof (double)));
 		memcpy ((void *)&yy[np], (void *)ytmp, (size_t)(add * sizeof (double)));
 		np += add;
-		GMT_free ((void *)xtmp);	GMT_free ((void *)ytmp);
+		GMT_arena_release (A, (void *)xtmp);	GMT_arena_release (A, (void *)ytmp);
 	}
 	
         *x = xx;
@@ -6031,30 +7358,55 @@ int GMT_graticule_path (double **x, double **y, int dir, double w, double e, dou
         return (np);
 }
 
-int GMT_map_path (double lon1, double lat1, double lon2, double lat2, double **x, double **y)
+int GMT_map_path (double lon1, double lat1, double lon2, double lat2, BOOLEAN straight, double **x, double **y, struct GMT_ARENA *A)
 {
+	/* Path along a parallel or meridian, in memory from A (NULL for GMT_memory).
+	 * With straight it is a straight line in lon/lat, whatever the map */
+
 	if (fabs (lat1 - lat2) < 1.0e-10)
-		return (GMT_latpath (lat1, lon1, lon2, x, y));
+		return ((straight) ? GMT_straight_latpath (lat1, lon1, lon2, x, y, A) : GMT_latpath (lat1, lon1, lon2, x, y, A));
 	else
-		return (GMT_lonpath (lon1, lat1, lat2, x, y));
+		return ((straight) ? GMT_straight_lonpath (lon1, lat1, lat2, x, y, A) : GMT_lonpath (lon1, lat1, lat2, x, y, A));
+}
+
+int GMT_straight_lonpath (double lon, double lat1, double lat2, double **x, double **y, struct GMT_ARENA *A)
+{
+	/* GMT_lonpath where meridians are straight: just the two ends */
+
+	double *tlon, *tlat;
+
+	tlon = (double *) GMT_arena_alloc (A, (size_t)2, sizeof (double));
+	tlat = (double *) GMT_arena_alloc (A, (size_t)2, sizeof (double));
+	tlon[0] = tlon[1] = lon;
+	tlat[0] = lat1;	tlat[1] = lat2;
+	*x = tlon;
+	*y = tlat;
+	return (2);
+}
+
+int GMT_straight_latpath (double lat, double lon1, double lon2, double **x, double **y, struct GMT_ARENA *A)
+{
+	/* GMT_latpath where parallels are straight: the ends and the quarter points */
+
+	double dlon, *tlon, *tlat;
+
+	tlon = (double *) GMT_arena_alloc (A, (size_t)5, sizeof (double));
+	tlat = (double *) GMT_arena_alloc (A, (size_t)5, sizeof (double));
+	tlat[0] = tlat[1] = tlat[2] = tlat[3] = tlat[4] = lat;
+	dlon = lon2 - lon1;
+	tlon[0] = lon1;	tlon[1] = lon1 + 0.25 * dlon;	tlon[2] = lon1 + 0.5 * dlon;
+	tlon[3] = lon1 + 0.75 * dlon;	tlon[4] = lon2;
+	*x = tlon;	*y = tlat;
+	return (5);
 }
 
-int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y)
+int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y, struct GMT_ARENA *A)
 {
 	int ny, n, n_try, keep_trying, jump, pos;
 	double dlat, dlat0, *tlon, *tlat, x0, x1, y0, y1, d;
 	double min_gap;
 
-	if (GMT_meridian_straight) {	/* Easy, just a straight line connect */
-		n = 2;
-		tlon = (double *) GMT_memory (VNULL, (size_t)n, sizeof (double), "GMT_lonpath");
-		tlat = (double *) GMT_memory (VNULL, (size_t)n, sizeof (double), "GMT_lonpath");
-	        tlon[0] = tlon[1] = lon;
-	        tlat[0] = lat1;	tlat[1] = lat2;
-	        *x = tlon;
-	        *y = tlat;
-	        return (n);
-	}
+	if (GMT_meridian_straight) return (GMT_straight_lonpath (lon, lat1, lat2, x, y, A));	/* Easy, just a straight line connect */
 	
 	n = 0;
 	min_gap = 0.1 * gmtdefs.line_step;
@@ -6064,8 +7416,8 @@ int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y)
 	dlat0 = (lat2 - lat1) / ny;
 	pos = (dlat0 > 0.0); 
 	
-	tlon = (double *) GMT_memory (VNULL, (size_t)ny, sizeof (double), "GMT_lonpath");
-	tlat = (double *) GMT_memory (VNULL, (size_t)ny, sizeof (double), "GMT_lonpath");
+	tlon = (double *) GMT_arena_alloc (A, (size_t)ny, sizeof (double));
+	tlat = (double *) GMT_arena_alloc (A, (size_t)ny, sizeof (double));
 	
 	tlon[0] = lon;
 	tlat[0] = lat1;
@@ -6073,9 +7425,9 @@ int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y)
 	while ((pos && (tlat[n] < lat2)) || (!pos && (tlat[n] > lat2))) {
 		n++;
 		if (n == ny-1) {
+			tlon = (double *) GMT_arena_grow (A, (void *)tlon, (size_t)ny, (size_t)(ny + GMT_SMALL_CHUNK), sizeof (double));
+			tlat = (double *) GMT_arena_grow (A, (void *)tlat, (size_t)ny, (size_t)(ny + GMT_SMALL_CHUNK), sizeof (double));
 			ny += GMT_SMALL_CHUNK;
-			tlon = (double *) GMT_memory ((void *)tlon, (size_t)ny, sizeof (double), "GMT_lonpath");
-			tlat = (double *) GMT_memory ((void *)tlat, (size_t)ny, sizeof (double), "GMT_lonpath");
 		}
 		n_try = 0;
 		keep_trying = TRUE;
@@ -6100,7 +7452,7 @@ int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y)
 	tlat[n] = lat2;
 	n++;
 	
-	if (n != ny) {
+	if (n != ny && !A) {	/* Arena pieces are not worth shrinking */
 		tlon = (double *) GMT_memory ((void *)tlon, (size_t)n, sizeof (double), "GMT_lonpath");
 		tlat = (double *) GMT_memory ((void *)tlat, (size_t)n, sizeof (double), "GMT_lonpath");
 	}
@@ -6109,23 +7461,13 @@ int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y)
 	return (n);
 }
 
-int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y)
+int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y, struct GMT_ARENA *A)
 {
 	int nx, n, n_try, keep_trying, jump, pos;
 	double dlon, dlon0, *tlon, *tlat, x0, x1, y0, y1, d;
 	double min_gap;
 
-	if (GMT_parallel_straight) {	/* Easy, just a straight line connection via quarter points */
-		n = 5;
-		tlon = (double *) GMT_memory (VNULL, (size_t)n, sizeof (double), "GMT_latpath");
-		tlat = (double *) GMT_memory (VNULL, (size_t)n, sizeof (double), "GMT_latpath");
-		tlat[0] = tlat[1] = tlat[2] = tlat[3] = tlat[4] = lat;
-		dlon = lon2 - lon1;
-		tlon[0] = lon1;	tlon[1] = lon1 + 0.25 * dlon;	tlon[2] = lon1 + 0.5 * dlon;
-		tlon[3] = lon1 + 0.75 * dlon;	tlon[4] = lon2;
-		*x = tlon;	*y = tlat;
-		return (n);
-	}
+	if (GMT_parallel_straight) return (GMT_straight_latpath (lat, lon1, lon2, x, y, A));	/* Easy, just a straight line connection via quarter points */
 
 	n = 0;
 	min_gap = 0.1 * gmtdefs.line_step;
@@ -6135,8 +7477,8 @@ int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y)
 	dlon0 = (lon2 - lon1) / nx;
 	pos = (dlon0 > 0.0); 
 	
-	tlon = (double *) GMT_memory (VNULL, (size_t)nx, sizeof (double), "GMT_latpath");
-	tlat = (double *) GMT_memory (VNULL, (size_t)nx, sizeof (double), "GMT_latpath");
+	tlon = (double *) GMT_arena_alloc (A, (size_t)nx, sizeof (double));
+	tlat = (double *) GMT_arena_alloc (A, (size_t)nx, sizeof (double));
 	
 	tlon[0] = lon1;
 	tlat[0] = lat;
@@ -6144,9 +7486,9 @@ int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y)
 	while ((pos && (tlon[n] < lon2)) || (!pos && (tlon[n] > lon2))) {
 		n++;
 		if (n == nx-1) {
+			tlon = (double *) GMT_arena_grow (A, (void *)tlon, (size_t)nx, (size_t)(nx + GMT_CHUNK), sizeof (double));
+			tlat = (double *) GMT_arena_grow (A, (void *)tlat, (size_t)nx, (size_t)(nx + GMT_CHUNK), sizeof (double));
 			nx += GMT_CHUNK;
-			tlon = (double *) GMT_memory ((void *)tlon, (size_t)nx, sizeof (double), "GMT_latpath");
-			tlat = (double *) GMT_memory ((void *)tlat, (size_t)nx, sizeof (double), "GMT_latpath");
 		}
 		n_try = 0;
 		keep_trying = TRUE;
@@ -6170,7 +7512,7 @@ int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y)
 	tlat[n] = lat;
 	n++;
 	
-	if (n != nx) {
+	if (n != nx && !A) {	/* Arena pieces are not worth shrinking */
 		tlon = (double *) GMT_memory ((void *)tlon, (size_t)n, sizeof (double), "GMT_latpath");
 		tlat = (double *) GMT_memory ((void *)tlat, (size_t)n, sizeof (double), "GMT_latpath");
 	}
@@ -6410,6 +7752,15 @@ int GMT_lon_inside (double lon, double w, double e)
 int GMT_geo_to_xy_line (double *lon, double *lat, int n)
 {
 	/* Traces the lon/lat array and returns x,y plus appropriate pen moves */
+
+	return (GMT_geo_to_xy_line_xy (lon, lat, (double *)NULL, (double *)NULL, n));
+}
+
+int GMT_geo_to_xy_line_xy (double *lon, double *lat, double *x, double *y, int n)
+{
+	/* GMT_geo_to_xy_line, with x/y (if not NULL) holding lon/lat already
+	 * converted by GMT_geo_to_xy_array, so the points are projected in one
+	 * pass of the array kernel and only the crossings one at a time */
 	int j, np, this, nx, sides[2], wrap = FALSE, ok = FALSE;
 	double xlon[2], xlat[2], xx[2], yy[2];
 	double this_x, this_y, last_x, last_y, dummy[2];
@@ -6417,13 +7768,21 @@ int GMT_geo_to_xy_line (double *lon, double *lat, int n)
 	if (n > GMT_n_alloc) GMT_get_plot_array ();
 	
 	np = 0;
-	GMT_geo_to_xy (lon[0], lat[0], &last_x, &last_y);
+	if (x) {
+		last_x = x[0];	last_y = y[0];
+	}
+	else
+		GMT_geo_to_xy (lon[0], lat[0], &last_x, &last_y);
 	if (!GMT_map_outside (lon[0], lat[0])) {
 		GMT_x_plot[0] = last_x;	 GMT_y_plot[0] = last_y;
 		GMT_pen[np++] = 3;
 	}
 	for (j = 1; j < n; j++) {
-		GMT_geo_to_xy (lon[j], lat[j], &this_x, &this_y);
+		if (x) {
+			this_x = x[j];	this_y = y[j];
+		}
+		else
+			GMT_geo_to_xy (lon[j], lat[j], &this_x, &this_y);
 		this = GMT_map_outside (lon[j], lat[j]);
 		nx = 0;
 		if (GMT_break_through (lon[j-1], lat[j-1], lon[j], lat[j]))	{ /* Crossed map boundary */
@@ -6502,6 +7861,66 @@ int GMT_compact_line (double *x, double *y, int n, BOOLEAN pen_flag, int *pen)
 	return (j);
 }
 
+int GMT_simplify_line (double *x, double *y, int n, double tolerance, char *keep)
+{	/* Douglas-Peucker: sets keep[i] for the points needed to follow the line
+	 * within tolerance of x/y.  The first and last points are always kept, so
+	 * lines still meet where they did and closed lines stay closed.  Returns
+	 * the number of points kept */
+	int i, k, m, first, last, n_stack, *stack;
+	double dx, dy, ex, ey, t, len2, d2, d2_max, tol2;
+	
+	if (n < 3) {
+		for (i = 0; i < n; i++) keep[i] = 1;
+		return (n);
+	}
+	memset ((void *)keep, 0, (size_t)n);
+	keep[0] = keep[n-1] = 1;
+	tol2 = tolerance * tolerance;
+	
+	stack = (int *) GMT_memory (VNULL, (size_t)(2 * n), sizeof (int), "GMT_simplify_line");
+	stack[0] = 0;
+	stack[1] = n - 1;
+	for (n_stack = 1, m = 2; n_stack > 0;) {	/* Spans still to check, instead of recursion */
+		n_stack--;
+		first = stack[2*n_stack];
+		last = stack[2*n_stack+1];
+		dx = x[last] - x[first];
+		dy = y[last] - y[first];
+		len2 = dx * dx + dy * dy;
+		for (i = first + 1, k = -1, d2_max = tol2; i < last; i++) {	/* Farthest point from the segment */
+			ex = x[i] - x[first];
+			ey = y[i] - y[first];
+			t = (len2 > 0.0) ? (ex * dx + ey * dy) / len2 : 0.0;
+			if (t > 1.0) t = 1.0;
+			if (t > 0.0) {
+				ex -= t * dx;
+				ey -= t * dy;
+			}
+			d2 = ex * ex + ey * ey;
+			if (d2 > d2_max) {
+				d2_max = d2;
+				k = i;
+			}
+		}
+		if (k < 0) continue;
+		keep[k] = 1;
+		m++;
+		if (k - first > 1) {
+			stack[2*n_stack] = first;
+			stack[2*n_stack+1] = k;
+			n_stack++;
+		}
+		if (last - k > 1) {
+			stack[2*n_stack] = k;
+			stack[2*n_stack+1] = last;
+			n_stack++;
+		}
+	}
+	GMT_free ((void *)stack);
+	
+	return (m);
+}
+
 /* Routines to transform grdfiles to/from map projections */
 
 void GMT_grd_forward (float *geo, struct GRD_HEADER *g_head, float *rect, struct GRD_HEADER *r_head, double max_radius, BOOLEAN center)
@@ -7177,6 +8596,71 @@ double	GMT_lat_swap (double lat, int itype)
 	return (lat + R2D * delta);
 }
 
+void	GMT_lat_swap_array (double *lat, double *out, int n, int itype, BOOLEAN table)
+{
+	/* GMT_lat_swap_quick for n latitudes in degrees, with the coefficients of
+	 * itype; out may be lat.  With table the change in latitude is interpolated
+	 * from GMT_lat_swap_table instead of summed, within 1e-13 degrees of it */
+
+	int	i, j;
+	double	c0, c1, c2, c3, t, v, s2, c2phi, u, r, r2, *d;
+
+	if (table) {
+		d = GMT_lat_swap_table (itype);
+		for (i = 0; i < n; i++) {
+			t = lat[i];
+			u = (fabs (t) < 90.0) ? fabs (t) * GMT_LATSWAP_TAB_SCL : 0.0;
+			j = (int)u;
+			r = u - j;
+			r2 = r * r;
+			v = d[2*j] + r2 * (3.0 - 2.0 * r) * (d[2*j+2] - d[2*j]) + r * (1.0 - r) * ((1.0 - r) * d[2*j+1] - r * d[2*j+3]);
+			v = t + copysign (1.0, t) * v;
+			v = (fabs (t) < GMT_CONV_LIMIT) ? 0.0 : v;
+			v = (t >= 90.0) ? 90.0 : v;
+			out[i] = (t <= -90.0) ? -90.0 : v;
+		}
+		return;
+	}
+
+	c0 = GMT_lat_swap_vals.c[itype][0];	c1 = GMT_lat_swap_vals.c[itype][1];
+	c2 = GMT_lat_swap_vals.c[itype][2];	c3 = GMT_lat_swap_vals.c[itype][3];
+	for (i = 0; i < n; i++) {
+		t = lat[i];
+		sincos (2.0 * t * D2R, &s2, &c2phi);
+		v = t + R2D * (s2 * (c0 + c2phi * (c1 + c2phi * (c2 + c2phi * c3) ) ) );
+		v = (fabs (t) < GMT_CONV_LIMIT) ? 0.0 : v;
+		v = (t >= 90.0) ? 90.0 : v;
+		out[i] = (t <= -90.0) ? -90.0 : v;
+	}
+}
+
+double	*GMT_lat_swap_table (int itype)
+{
+	/* Returns the lookup table for itype, remade if the coefficients changed
+	 * since.  Node j, at j / GMT_LATSWAP_TAB_SCL degrees, holds the change in
+	 * latitude and its derivative times the node spacing, for cubic Hermite
+	 * interpolation.  The change is odd in latitude, so 0-90 will do */
+
+	int	j;
+	double	*c, *d, s2, c2phi, p, dp;
+
+	c = GMT_lat_swap_vals.c[itype];
+	d = GMT_lat_swap_vals.tab[itype];
+	if (d && !memcmp ((void *)GMT_lat_swap_vals.tab_c[itype], (void *)c, 4 * sizeof (double))) return (d);
+
+	if (!d) d = (double *) GMT_memory (VNULL, (size_t)(2 * (GMT_LATSWAP_TAB_N + 1)), sizeof (double), "GMT_lat_swap_table");
+	for (j = 0; j <= GMT_LATSWAP_TAB_N; j++) {
+		sincos (2.0 * D2R * j / GMT_LATSWAP_TAB_SCL, &s2, &c2phi);
+		p = c[0] + c2phi * (c[1] + c2phi * (c[2] + c2phi * c[3]));
+		dp = c[1] + c2phi * (2.0 * c[2] + 3.0 * c2phi * c[3]);
+		d[2*j] = R2D * s2 * p;
+		d[2*j+1] = 2.0 * (c2phi * p - s2 * s2 * dp) / GMT_LATSWAP_TAB_SCL;
+	}
+	memcpy ((void *)GMT_lat_swap_vals.tab_c[itype], (void *)c, 4 * sizeof (double));
+	GMT_lat_swap_vals.tab[itype] = d;
+	return (d);
+}
+
 void	GMT_lat_swap_init ()
 {
 	/* Initialize values in GMT_lat_swap_vals based on project_info.
@@ -17,6 +17,11 @@
  *--------------------------------------------------------------------*/
 
 #include "gmt.h"
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 /*
  * These functions simplifies the access to the GMT shoreline, border, and river
@@ -29,12 +34,20 @@
  * GMT_init_br :		Opens selected border/river database and initializes structures
  * GMT_get_br_bin :		Returns all selected border/river data for this bin
  * GMT_assemble_shore :		Creates polygons or lines from shoreline segments
+ * GMT_merge_shore :		Joins the shoreline segments of many bins into closed polygons
+ * GMT_stitch_lines :		Joins lines of many bins that meet on bin edges
  * GMT_prep_polygons :		Wraps polygons if necessary and prepares them for use
  * GMT_assemble_br :		Creates lines from border or river segments
  * GMT_free_shore :		Frees up memory used by shorelines for this bin
  * GMT_free_br :		Frees up memory used by shorelines for this bin
  * GMT_shore_cleanup :		Frees up main shoreline structure memory
  * GMT_br_cleanup :		Frees up main river/border structure memory
+ * GMT_shore_cache_size :	Sets the memory budget of the shared bin cache
+ * GMT_shore_cache_stats :	Returns hits, misses, bytes and entries of the bin cache
+ * GMT_shore_cache_flush :	Empties the bin cache and closes all databases
+ * GMT_shore_convert :		Writes a database in the compact memory-mappable format
+ * GMT_shore_index :		Writes the bin index of a database
+ * GMT_shore_rank :		Writes the point ranks used to thin a database while reading it
  *
  * Author:	Paul Wessel
  * Date:	13-JUN-1995
@@ -47,6 +60,15 @@ int GMT_copy_to_shore_path (double *lon, double *lat, struct GMT_SHORE *s, int i
 int GMT_shore_get_first_entry (struct GMT_SHORE *c, int dir, int *side);
 int GMT_shore_get_position (int side, short int x, short int y);
 int GMT_shore_get_next_entry (struct GMT_SHORE *c, int dir, int side, int id);
+int GMT_shore_grow_path (struct POL *p, int n, int n_alloc, int add, struct GMT_ARENA *A);
+int GMT_shore_close_chains (struct POL *chain, double *t_in, double *t_out, int nc, int level, BOOLEAN reverse, int new_level, BOOLEAN whole, struct GMT_SHORE_OUTLINE *B, struct POL **ring, int n_ring, int *r_alloc);
+int GMT_shore_next_piece (struct POL *p, int *head, int *next, int *used, int k, struct GMT_SHORE_OUTLINE *B, int nh);
+int GMT_shore_key (double lon, double lat, struct GMT_SHORE_OUTLINE *B, int nh);
+double GMT_shore_outline_pos (struct GMT_SHORE_OUTLINE *B, double lon, double lat);
+int GMT_shore_ring_walk (struct POL *r, int n_alloc, struct GMT_SHORE_OUTLINE *B, double t0, double d, int walk);
+int GMT_shore_ring_add (struct POL *r, int n_alloc, double *lon, double *lat, int n, BOOLEAN reverse, double tol);
+int GMT_shore_push_ring (struct POL **ring, int n_ring, int *r_alloc, struct POL *r);
+BOOLEAN GMT_stitch_end (struct POL *p, int e, struct GMT_SHORE_OUTLINE *B, double *lon, double *lat);
 int GMT_copy_to_br_path (double *lon, double *lat, struct GMT_BR *s, int id);
 void GMT_shore_to_degree (struct GMT_SHORE *c, short int dx, short int dy, double *lon, double *lat);
 void GMT_shore_pau_sides (struct GMT_SHORE *c);
@@ -56,6 +78,256 @@ void GMT_br_to_degree (struct GMT_BR *c, short int dx, short int dy, double *lon
 void shore_prepare_sides(struct GMT_SHORE *c, int dir);
 int GMT_shore_asc_sort (const void *a, const void *b);
 int GMT_shore_desc_sort(const void *a, const void *b);
+struct GMT_SHORE_DB *GMT_shore_get_db (char kind, char res);
+void GMT_shore_close_db (struct GMT_SHORE_DB *db);
+void GMT_shore_drop_db (struct GMT_SHORE_DB *db);
+void GMT_shore_read_header (struct GMT_SHORE *c, char *path);
+void GMT_shore_read_bin (int b, struct GMT_SHORE *c, int cut_area, int min_level, int max_level);
+void GMT_br_read_bin (int b, struct GMT_BR *c, int *level, int n_levels);
+void GMT_br_read_header (struct GMT_BR *c, char *path);
+void GMT_shore_file_name (char kind, char res, char *suffix, char *file);
+int GMT_shore_map_db (struct GMT_SHORE_DB *db, char *path);
+char *GMT_shore_map (char *path, size_t *size);
+void GMT_shore_unmap (char *map, size_t size);
+int GMT_shore_map_segments (struct GMT_SHORE *c, int b, int cut_area, int min_level, int max_level, int *offset);
+int GMT_br_map_segments (struct GMT_BR *c, int b, int *level, int n_levels, int *offset);
+int GMT_shore_tally (int n_bin, short *bin_nseg, int *bin_firstseg, int *seg_n, int *seg_level, int **bin_npt, unsigned char **bin_used, int *top_level);
+void GMT_shore_index_map (struct GMT_SHORE_DB *db);
+int GMT_shore_read_index (struct GMT_SHORE_DB *db, char *path);
+int GMT_shore_read_rank (struct GMT_SHORE_DB *db, char *path);
+int GMT_shore_rank_of (double area);
+double GMT_shore_rank_area (short *dx, short *dy, int p, int i, int q);
+void GMT_shore_rank_segment (short *dx, short *dy, int n, unsigned char *rank, int *work, double *area);
+void GMT_shore_heap_fix (int *heap, int *pos, double *area, int nh, int k);
+int GMT_shore_thin_copy (short *dx, short *dy, int n, unsigned char *rank, int min_rank, short *out);
+short *GMT_shore_thin (struct GMT_SHORE_SEGMENT *seg, int ns, int *offset, unsigned char *rank, int min_rank, int *n_pt);
+short *GMT_br_thin (struct GMT_BR_SEGMENT *seg, int ns, int *offset, unsigned char *rank, int min_rank, int *n_pt);
+void GMT_shore_file_name (char kind, char res, char *suffix, char *file)
+{
+	if (kind == 'c')
+		sprintf (file, "binned_GSHHS_%c.%s\0", res, suffix);
+	else if (kind == 'r')
+		sprintf (file, "binned_river_%c.%s\0", res, suffix);
+	else
+		sprintf (file, "binned_border_%c.%s\0", res, suffix);
+}
+
+int GMT_shore_map_db (struct GMT_SHORE_DB *db, char *path)
+{
+	/* Maps a compact database written by GMT_shore_convert and sets up db from its
+	 * header.  Returns -1 if the file cannot be used so the netcdf file is read instead */
+	 
+	int i;
+	char *map;
+	size_t size, need;
+	short *bin_info, *bin_nseg;
+	int *bin_firstseg;
+	struct GMT_SHORE_FILE_HEADER *h;
+	struct GMT_SHORE_FILE_BIN *bin;
+	
+	if ((map = GMT_shore_map (path, &size)) == NULL) return (-1);
+	
+	h = (struct GMT_SHORE_FILE_HEADER *)map;
+	need = sizeof (struct GMT_SHORE_FILE_HEADER);
+	if (size < need || strncmp (h->magic, GMT_SHORE_MAGIC, (size_t)8) || h->version != GMT_SHORE_VERSION || h->byte_order != GMT_SHORE_BYTE_ORDER || h->kind != db->kind || h->n_bin < 0 || h->n_seg < 0 || h->n_pt < 0)
+		need = 0;
+	else
+		need += h->n_bin * sizeof (struct GMT_SHORE_FILE_BIN) + h->n_seg * sizeof (struct GMT_SHORE_FILE_SEG) + 2 * h->n_pt * sizeof (short);
+	if (size != need) {
+		fprintf (stderr, "%s: Warning: %s is not a usable compact database, reading netcdf file instead\n", GMT_program, path);
+		GMT_shore_unmap (map, size);
+		return (-1);
+	}
+	
+	bin = (struct GMT_SHORE_FILE_BIN *)(map + sizeof (struct GMT_SHORE_FILE_HEADER));
+	bin_info = (short *) GMT_memory (VNULL, (size_t)h->n_bin, sizeof (short), "GMT_shore_map_db");
+	bin_nseg = (short *) GMT_memory (VNULL, (size_t)h->n_bin, sizeof (short), "GMT_shore_map_db");
+	bin_firstseg = (int *) GMT_memory (VNULL, (size_t)h->n_bin, sizeof (int), "GMT_shore_map_db");
+	for (i = 0; i < h->n_bin; i++) {
+		bin_info[i] = bin[i].info;
+		bin_nseg[i] = bin[i].nseg;
+		bin_firstseg[i] = bin[i].firstseg;
+	}
+	
+	if (db->kind == 'c') {
+		db->shore.bin_size = h->bin_size;	db->shore.bin_nx = h->bin_nx;	db->shore.bin_ny = h->bin_ny;
+		db->shore.n_bin = h->n_bin;	db->shore.n_seg = h->n_seg;	db->shore.n_pt = h->n_pt;
+		memcpy ((void *)db->shore.units, (void *)h->units, (size_t)80);
+		memcpy ((void *)db->shore.title, (void *)h->title, (size_t)80);
+		memcpy ((void *)db->shore.source, (void *)h->source, (size_t)80);
+		db->shore.scale = (h->bin_size / 60.0) / 65535.0;
+		db->shore.bsize = h->bin_size / 60.0;
+		db->shore.bin_info = bin_info;
+		db->shore.bin_nseg = bin_nseg;
+		db->shore.bin_firstseg = bin_firstseg;
+		db->shore.map = map;
+		db->shore.map_size = size;
+		db->shore.map_seg = (struct GMT_SHORE_FILE_SEG *)(&bin[h->n_bin]);
+		db->shore.map_pt = (short *)(&db->shore.map_seg[h->n_seg]);
+		db->shore.cdfid = -1;
+	}
+	else {
+		GMT_free ((void *)bin_info);
+		db->br.bin_size = h->bin_size;	db->br.bin_nx = h->bin_nx;	db->br.bin_ny = h->bin_ny;
+		db->br.n_bin = h->n_bin;	db->br.n_seg = h->n_seg;	db->br.n_pt = h->n_pt;
+		memcpy ((void *)db->br.units, (void *)h->units, (size_t)80);
+		memcpy ((void *)db->br.title, (void *)h->title, (size_t)80);
+		memcpy ((void *)db->br.source, (void *)h->source, (size_t)80);
+		db->br.scale = (h->bin_size / 60.0) / 65535.0;
+		db->br.bsize = h->bin_size / 60.0;
+		db->br.bin_nseg = bin_nseg;
+		db->br.bin_firstseg = bin_firstseg;
+		db->br.map = map;
+		db->br.map_size = size;
+		db->br.map_seg = (struct GMT_SHORE_FILE_SEG *)(&bin[h->n_bin]);
+		db->br.map_pt = (short *)(&db->br.map_seg[h->n_seg]);
+		db->br.cdfid = -1;
+	}
+	
+	return (0);
+}
+
+char *GMT_shore_map (char *path, size_t *size)
+{	/* Returns a read-only image of the file and sets size, or NULL and size 0 on failure */
+	char *map;
+#ifdef WIN32
+	FILE *fp;
+	long n;
+	
+	*size = 0;
+	if ((fp = fopen (path, "rb")) == NULL) return (CNULL);
+	fseek (fp, 0L, SEEK_END);
+	if ((n = ftell (fp)) <= 0) {
+		fclose (fp);
+		return (CNULL);
+	}
+	rewind (fp);
+	map = (char *) GMT_memory (VNULL, (size_t)n, (size_t)1, "GMT_shore_map");
+	if (fread ((void *)map, (size_t)1, (size_t)n, fp) != (size_t)n) {
+		GMT_free ((void *)map);
+		map = CNULL;
+	}
+	fclose (fp);
+	if (map) *size = (size_t)n;
+#else
+	int fd;
+	struct stat buf;
+	
+	*size = 0;
+	if ((fd = open (path, O_RDONLY)) < 0) return (CNULL);
+	if (fstat (fd, &buf) || buf.st_size == 0 || (map = (char *) mmap (VNULL, (size_t)buf.st_size, PROT_READ, MAP_SHARED, fd, (off_t)0)) == (char *)MAP_FAILED)
+		map = CNULL;
+	else
+		*size = (size_t)buf.st_size;
+	close (fd);
+#endif
+	return (map);
+}
+
+void GMT_shore_unmap (char *map, size_t size)
+{
+#ifdef WIN32
+	GMT_free ((void *)map);
+#else
+	munmap ((void *)map, size);
+#endif
+}
+
+int GMT_shore_map_segments (struct GMT_SHORE *c, int b, int cut_area, int min_level, int max_level, int *offset)
+{
+	/* Sets c->seg to the selected segments of bin b in a mapped database and returns
+	 * how many there are.  dx and dy point into the mapping and are never copied.
+	 * If offset is not NULL it gets the rank offset of every selected segment */
+	 
+	int i, s, level;
+	struct GMT_SHORE_FILE_SEG *fs;
+	
+	fs = &c->map_seg[c->bin_firstseg[b]];
+	c->seg = (struct GMT_SHORE_SEGMENT *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (struct GMT_SHORE_SEGMENT), "GMT_shore_map_segments");
+	
+	for (i = s = 0; i < c->bin_nseg[b]; i++) {
+		if (cut_area > 0 && fs[i].area < cut_area) continue;
+		level = (fs[i].info >> 6) & 7;
+		if (level < min_level || level > max_level) continue;
+		c->seg[s].level = level;
+		c->seg[s].n = (fs[i].info >> 9);
+		c->seg[s].entry = (fs[i].info >> 3) & 7;
+		c->seg[s].exit = fs[i].info & 7;
+		c->seg[s].dx = &c->map_pt[2 * fs[i].start];
+		c->seg[s].dy = c->seg[s].dx + c->seg[s].n;
+		if (offset) offset[s] = c->rank_start[c->bin_firstseg[b] + i];
+		s++;
+	}
+	
+	if (s == 0) {
+		GMT_free ((void *)c->seg);
+		c->seg = (struct GMT_SHORE_SEGMENT *)NULL;
+	}
+	return (s);
+}
+
+int GMT_br_map_segments (struct GMT_BR *c, int b, int *level, int n_levels, int *offset)
+{
+	/* Sets c->seg to the selected segments of bin b in a mapped database and returns
+	 * how many there are.  dx and dy point into the mapping and are never copied.
+	 * If offset is not NULL it gets the rank offset of every selected segment */
+	 
+	int i, k, s, skip;
+	struct GMT_SHORE_FILE_SEG *fs;
+	
+	fs = &c->map_seg[c->bin_firstseg[b]];
+	c->seg = (struct GMT_BR_SEGMENT *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (struct GMT_BR_SEGMENT), "GMT_br_map_segments");
+	
+	for (i = s = 0; i < c->bin_nseg[b]; i++) {
+		if (n_levels == 0)
+			skip = FALSE;
+		else {
+			for (k = 0, skip = TRUE; skip && k < n_levels; k++)
+				if (fs[i].area == level[k]) skip = FALSE;
+		}
+		if (skip) continue;
+		c->seg[s].n = fs[i].info;
+		c->seg[s].level = fs[i].area;
+		c->seg[s].dx = &c->map_pt[2 * fs[i].start];
+		c->seg[s].dy = c->seg[s].dx + c->seg[s].n;
+		if (offset) offset[s] = c->rank_start[c->bin_firstseg[b] + i];
+		s++;
+	}
+	
+	if (s == 0) {
+		GMT_free ((void *)c->seg);
+		c->seg = (struct GMT_BR_SEGMENT *)NULL;
+	}
+	return (s);
+}
+
+int GMT_bin_cache_key (char kind, char res, int bin, int filter[]);
+struct GMT_BIN_CACHE *GMT_bin_cache_find (char kind, char res, int bin, int filter[]);
+struct GMT_BIN_CACHE *GMT_bin_cache_add (char kind, char res, int bin, int filter[], int ns, void *seg, short *arena, size_t bytes);
+void GMT_bin_cache_release (struct GMT_BIN_CACHE *e);
+void GMT_bin_cache_trim (void);
+void GMT_bin_cache_evict (struct GMT_BIN_CACHE *e);
+void GMT_bin_cache_unlink (struct GMT_BIN_CACHE *e);
+void GMT_bin_cache_push (struct GMT_BIN_CACHE *e);
+
+/* Local variables to gmt_shore.c.  Database headers and decoded bins are shared by
+ * all readers for the life of the process so that repeated extractions over the
+ * same area need no netcdf i/o.  Bins are evicted in least recently used order.
+ * With GMT_THREADS they are only touched while holding the shore lock, so each
+ * thread may run its own GMT_SHORE and GMT_BR readers at the same time. */
+
+struct GMT_SHORE_DB *GMT_shore_db = NULL;		/* List of open databases */
+struct GMT_BIN_CACHE *GMT_bin_hash[GMT_BIN_CACHE_HASH];	/* Hash buckets for bin lookup */
+struct GMT_BIN_CACHE *GMT_bin_lru_head = NULL;		/* Most recently used bin */
+struct GMT_BIN_CACHE *GMT_bin_lru_tail = NULL;		/* Least recently used bin */
+long GMT_bin_cache_budget = GMT_BIN_CACHE_SIZE;	/* Max bytes held by cached bins */
+long GMT_bin_cache_bytes = 0;			/* Bytes currently held */
+long GMT_bin_cache_n = 0;			/* Number of cached bins */
+long GMT_bin_cache_hits = 0, GMT_bin_cache_misses = 0;
+double GMT_shore_tolerance[5] = {0.0, 0.2, 1.0, 5.0, 25.0};	/* DP line reduction (km) of f, h, i, l, c */
+#ifdef GMT_THREADS
+pthread_mutex_t GMT_shore_mutex = PTHREAD_MUTEX_INITIALIZER;	/* Guards all of the above and netcdf access */
+#endif
 
 int check_nc_status (int status)
 {
@@ -100,57 +372,48 @@ int GMT_set_resolution (char *res, char opt)
 	return (base);
 }
 
+char GMT_shore_pick_resolution (char kind, double tolerance)
+{
+	/* Returns the coarsest installed resolution of the given kind (c, b, r) whose line
+	 * reduction is no larger than tolerance (in km), else the finest one installed,
+	 * or 0 if none is installed at all */
+	 
+	int base;
+	char res, best = 0, file[32], path[BUFSIZ];
+	
+	for (base = 4; base >= 0; base--) {	/* Crude first */
+		res = "fhilc"[base];
+		GMT_shore_file_name (kind, res, "bin", file);
+		if (!GMT_getpathname (file, path)) {
+			GMT_shore_file_name (kind, res, "cdf", file);
+			if (!GMT_getpathname (file, path)) continue;
+		}
+		best = res;
+		if (GMT_shore_tolerance[base] <= tolerance) break;
+	}
+	return (best);
+}
+
 int GMT_init_shore (char res, struct GMT_SHORE *c, double w, double e, double s, double n)
 /* res: Resolution (f, h, i, l, c */
                 
 {
 	int i, nb, idiv, iw, ie, is, in, this_south, this_west;
-	short *stmp;
-	int *itmp;
-	size_t start[1], count[1];
-	char file[32], path[BUFSIZ];
+	struct GMT_SHORE_DB *db;
 	
-	sprintf (file, "binned_GSHHS_%c.cdf\0", res);
+	GMT_shore_lock ();
+	if ((db = GMT_shore_get_db ('c', res))) db->n_readers++;	/* Stays open until GMT_shore_cleanup */
+	GMT_shore_unlock ();
+	if (db == NULL) return (-1);	/* Failed to find file */
 	
-        if (!GMT_getpathname (file, path)) return (-1);	/* Failed to find file */
-        
-	check_nc_status (nc_open (path, NC_NOWRITE,&c->cdfid));
-                
-	/* Get all id tags */
-	check_nc_status (nc_inq_varid (c->cdfid, "Bin_size_in_minutes", &c->bin_size_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_360_longitude_range", &c->bin_nx_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_180_degree_latitude_range", &c->bin_ny_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_file", &c->n_bin_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_file", &c->n_seg_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_points_in_file", &c->n_pt_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_segment_in_a_bin", &c->bin_firstseg_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Embedded_node_levels_in_a_bin", &c->bin_info_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_a_bin", &c->bin_nseg_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Embedded_npts_levels_exit_entry_for_a_segment", &c->seg_info_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Ten_times_the_km_squared_area_of_the_parent_polygon_of_a_segment", &c->seg_area_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_point_in_a_segment", &c->seg_start_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Relative_longitude_from_SW_corner_of_bin", &c->pt_dx_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Relative_latitude_from_SW_corner_of_bin", &c->pt_dy_id));
-
-	/* Get attributes */
-	check_nc_status (nc_get_att_text (c->cdfid, c->pt_dx_id, "units", c->units));
-        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "title", c->title));
-        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "source", c->source));
-
-	/* Get global variables */
-
-	start[0] = 0;
-
-	check_nc_status (nc_get_var1_int (c->cdfid, c->bin_size_id, start, &c->bin_size));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_nx_id, start, &c->bin_nx));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_ny_id, start, &c->bin_ny));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->n_bin_id, start, &c->n_bin));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->n_seg_id, start, &c->n_seg));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->n_pt_id, start, &c->n_pt));
-
-
-	c->scale = (c->bin_size / 60.0) / 65535.0;
-	c->bsize = c->bin_size / 60.0;
+	*c = db->shore;	/* Ids, attributes and global variables come from the cached header */
+	c->db = db;
+	c->ns = 0;
+	c->cache = NULL;
+	c->tolerance = 0.0;	/* Callers with ranks may thin bins by setting this */
+	c->west = w;
+	c->world_map = GMT_world_map;	/* Callers that keep their own map state may reset this */
+	c->straight = FALSE;	/* Bin edges follow the map unless the caller says otherwise */
 
 	c->bins = (int *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (int), "GMT_init_shore");
 	
@@ -174,42 +437,51 @@ int GMT_init_shore (char res, struct GMT_SHORE *c, double w, double e, double s,
 	c->bins = (int *) GMT_memory ((void *)c->bins, (size_t)nb, sizeof (int), "GMT_init_shore");
 	c->nb = nb;
 	
-	/* Get bin variables, then extract only those corresponding to the bins to use */
+	/* Extract the bin variables corresponding to the bins to use */
 
-	/* Allocate space for arrays of bin information */
-	
 	c->bin_info     = (short *) GMT_memory (VNULL, (size_t)nb, sizeof (short), "GMT_init_shore");
 	c->bin_nseg     = (short *) GMT_memory (VNULL, (size_t)nb, sizeof (short), "GMT_init_shore");
 	c->bin_firstseg     = (int *) GMT_memory (VNULL, (size_t)nb, sizeof (int), "GMT_init_shore");
 	
-	count[0] = c->n_bin;
-	stmp = (short *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (short), "GMT_init_shore");
-	
-	check_nc_status (nc_get_vara_short (c->cdfid, c->bin_info_id, start, count, stmp));
-	for (i = 0; i < c->nb; i++) c->bin_info[i] = stmp[c->bins[i]];
-	
-        check_nc_status (nc_get_vara_short (c->cdfid, c->bin_nseg_id, start, count, stmp));
-	for (i = 0; i < c->nb; i++) c->bin_nseg[i] = stmp[c->bins[i]];
-	GMT_free ((void *)stmp);
-	
-	itmp = (int *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (int), "GMT_init_shore");
-        check_nc_status (nc_get_vara_int (c->cdfid, c->bin_firstseg_id, start, count, itmp));
-	for (i = 0; i < c->nb; i++) c->bin_firstseg[i] = itmp[c->bins[i]];
+	for (i = 0; i < c->nb; i++) {
+		c->bin_info[i] = db->shore.bin_info[c->bins[i]];
+		c->bin_nseg[i] = db->shore.bin_nseg[c->bins[i]];
+		c->bin_firstseg[i] = db->shore.bin_firstseg[c->bins[i]];
+	}
 	
-	GMT_free ((void *)itmp);
+	if (db->shore.bin_npt) {	/* Point counts let callers size their output without reading bins */
+		c->bin_npt = (int *) GMT_memory (VNULL, (size_t)nb, sizeof (int), "GMT_init_shore");
+		for (i = 0; i < c->nb; i++) c->bin_npt[i] = db->shore.bin_npt[c->bins[i]];
+	}
 	
 	return (0);
 }
 
+void GMT_shore_lines_only (struct GMT_SHORE *c)
+{
+	/* Drops the bins without segments after GMT_init_shore.  They only matter
+	 * when polygons are assembled, so callers that just want lines skip them */
+	 
+	int i, nb;
+	
+	for (i = nb = 0; i < c->nb; i++) {
+		if (c->bin_nseg[i] == 0) continue;
+		c->bins[nb] = c->bins[i];
+		c->bin_info[nb] = c->bin_info[i];
+		c->bin_nseg[nb] = c->bin_nseg[i];
+		c->bin_firstseg[nb] = c->bin_firstseg[i];
+		if (c->bin_npt) c->bin_npt[nb] = c->bin_npt[i];
+		nb++;
+	}
+	c->nb = nb;
+}
+
 void GMT_get_shore_bin (int b, struct GMT_SHORE *c, double min_area, int min_level, int max_level)
 /* b: index number into c->bins */
 /* min_area: Polygons with area less than this are ignored */
 /* min_level: Polygons with lower levels are ignored */
 /* max_level: Polygons with higher levels are ignored */
 {
-	size_t start[1], count[1];
-	int cut_area, *seg_area, *seg_info, *seg_start;
-	int s, i;
 	double w, e, dx;
 	
 	c->node_level[0] = (unsigned char)MIN (((unsigned short)c->bin_info[b] >> 9) & 7, max_level);
@@ -220,67 +492,21 @@ void GMT_get_shore_bin (int b, struct GMT_SHORE *c, double min_area, int min_lev
 	c->lon_sw = (c->bins[b] % c->bin_nx) * dx;
 	c->lat_sw = 90.0 - ((c->bins[b] / c->bin_nx) + 1) * dx;
 	c->ns = 0;
+	c->cache = NULL;
+	c->arena = (short *)NULL;
 
 	/* Determine if this bin is one of the bins at the left side of the map */
 	
 	w = c->lon_sw;
-	while (w > project_info.w && GMT_world_map) w -= 360.0;
+	while (w > c->west && c->world_map) w -= 360.0;
 	e = w + dx;
-	c->leftmost_bin = ((w <= project_info.w) && (e > project_info.w));
+	c->leftmost_bin = ((w <= c->west) && (e > c->west));
 
 	if (c->bin_nseg[b] == 0) return;
 	
-	cut_area = irint (10.0 * min_area);
-	start[0] = c->bin_firstseg[b];
-	count[0] = c->bin_nseg[b];
-	
-	seg_area = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin");
-	seg_info = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin");
-	seg_start = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin");
-	
-	check_nc_status (nc_get_vara_int (c->cdfid, c->seg_area_id, start, count, seg_area));
-        check_nc_status (nc_get_vara_int (c->cdfid, c->seg_info_id, start, count, seg_info));
-        check_nc_status (nc_get_vara_int (c->cdfid, c->seg_start_id, start, count, seg_start));
-	
-	/* First tally how many useful segments */
-	
-	for (s = i = 0; i < c->bin_nseg[b]; i++) {
-		if (cut_area > 0 && seg_area[i] < cut_area) continue;
-		if (((seg_info[i] >> 6) & 7) < min_level) continue;
-		if (((seg_info[i] >> 6) & 7) > max_level) continue;
-		seg_area[s] = seg_area[i];
-		seg_info[s] = seg_info[i];
-		seg_start[s] = seg_start[i];
-		s++;
-	}
-	c->ns = s;
-	
-	if (c->ns == 0) {	/* No useful segments in this bin */
-		GMT_free ((void *) seg_info);	
-		GMT_free ((void *) seg_area);	
-		GMT_free ((void *) seg_start);
-		return;
-	}
-	
-	c->seg = (struct GMT_SHORE_SEGMENT *) GMT_memory (VNULL, (size_t)c->ns, sizeof (struct GMT_SHORE_SEGMENT), "GMT_get_shore_bin");
-	
-	for (s = 0; s < c->ns; s++) {
-		c->seg[s].level = (seg_info[s] >> 6) & 7;
-		c->seg[s].n = (seg_info[s] >> 9);
-		c->seg[s].entry = (seg_info[s] >> 3) & 7;
-		c->seg[s].exit = seg_info[s] & 7;
-		c->seg[s].dx = (short *) GMT_memory (VNULL, (size_t)c->seg[s].n, sizeof (short), "GMT_get_shore_bin");
-		c->seg[s].dy = (short *) GMT_memory (VNULL, (size_t)c->seg[s].n, sizeof (short), "GMT_get_shore_bin");
-		start[0] = seg_start[s];
-		count[0] = c->seg[s].n;
-		check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dx_id, start, count, c->seg[s].dx));
-                check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dy_id, start, count, c->seg[s].dy));	
-	}
-		
-	GMT_free ((void *) seg_info);	
-	GMT_free ((void *) seg_area);	
-	GMT_free ((void *) seg_start);	
-	
+	GMT_shore_lock ();
+	GMT_shore_read_bin (b, c, irint (10.0 * min_area), min_level, max_level);
+	GMT_shore_unlock ();
 }
 
 int GMT_init_br (char which, char res, struct GMT_BR *c, double w, double e, double s, double n)
@@ -288,57 +514,18 @@ int GMT_init_br (char which, char res, struct GMT_BR *c, double w, double e, dou
 /* res: Resolution (f, h, i, l, c */
 {
 	int i, nb, idiv, iw, ie, is, in, this_south, this_west;
-	short *stmp;
-	int *itmp;
-	size_t start[1], count[1];
-	char file[32], path[BUFSIZ];
-	
-	if (which == 'r')
-		sprintf (file, "binned_river_%c.cdf\0", res);
-	else
-		sprintf (file, "binned_border_%c.cdf\0", res);
+	struct GMT_SHORE_DB *db;
 	
-        if (!GMT_getpathname (file, path)) return (-1);	/* Failed to find file */
-
-	check_nc_status (nc_open (path, NC_NOWRITE, &c->cdfid));
-        
-	/* Get all id tags */
-	check_nc_status (nc_inq_varid (c->cdfid, "Bin_size_in_minutes", &c->bin_size_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_360_longitude_range", &c->bin_nx_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_180_degree_latitude_range", &c->bin_ny_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_file", &c->n_bin_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_file", &c->n_seg_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_points_in_file", &c->n_pt_id));
-         
-        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_segment_in_a_bin", &c->bin_firstseg_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_a_bin", &c->bin_nseg_id));
-         
-        check_nc_status (nc_inq_varid (c->cdfid, "N_points_for_a_segment", &c->seg_n_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Hierarchial_level_of_a_segment", &c->seg_level_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_point_in_a_segment", &c->seg_start_id));
- 
-        check_nc_status (nc_inq_varid (c->cdfid, "Relative_longitude_from_SW_corner_of_bin", &c->pt_dx_id));
-        check_nc_status (nc_inq_varid (c->cdfid, "Relative_latitude_from_SW_corner_of_bin", &c->pt_dy_id));
-
-	/* Get attributes */
-	check_nc_status (nc_get_att_text (c->cdfid, c->pt_dx_id, "units", c->units));
-        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "title", c->title));
-        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "source", c->source));
-
-	/* Get global variables */
-
-	start[0] = 0;
+	GMT_shore_lock ();
+	if ((db = GMT_shore_get_db (which, res))) db->n_readers++;	/* Stays open until GMT_br_cleanup */
+	GMT_shore_unlock ();
+	if (db == NULL) return (-1);	/* Failed to find file */
 	
-	check_nc_status (nc_get_var1_int (c->cdfid, c->bin_size_id, start, &c->bin_size));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_nx_id, start, &c->bin_nx));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_ny_id, start, &c->bin_ny));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->n_bin_id, start, &c->n_bin));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->n_seg_id, start, &c->n_seg));
-        check_nc_status (nc_get_var1_int (c->cdfid, c->n_pt_id, start, &c->n_pt));
- 
-
-	c->scale = (c->bin_size / 60.0) / 65535.0;
-	c->bsize = c->bin_size / 60.0;
+	*c = db->br;	/* Ids, attributes and global variables come from the cached header */
+	c->db = db;
+	c->ns = 0;
+	c->cache = NULL;
+	c->tolerance = 0.0;
 
 	c->bins = (int *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (int), "GMT_init_br");
 	
@@ -351,6 +538,15 @@ int GMT_init_br (char which, char res, struct GMT_BR *c, double w, double e, dou
 	idiv = irint (360.0 / c->bsize);	/* Number of blocks per latitude band */
 	
 	for (i = nb = 0; i < c->n_bin; i++) {	/* Find which bins are needed */
+		if (c->bin_used) {	/* Bins without segments give nothing, so skip them */
+			if ((i & 7) == 0 && c->bin_used[i >> 3] == 0) {	/* Eight at a time */
+				i += 7;
+				continue;
+			}
+			if ((c->bin_used[i >> 3] & (1 << (i & 7))) == 0) continue;
+		}
+		else if (db->br.bin_nseg[i] == 0)
+			continue;
 		this_south = 90 - (int)(c->bsize * ((i / idiv) + 1));
 		if (this_south < is || this_south >= in) continue;
 		this_west = (int)(c->bsize * (i % idiv)) - 360;
@@ -362,25 +558,20 @@ int GMT_init_br (char which, char res, struct GMT_BR *c, double w, double e, dou
 	c->bins = (int *) GMT_memory ((void *)c->bins, (size_t)nb, sizeof (int), "GMT_init_br");
 	c->nb = nb;
 	
-	/* Get bin variables, then extract only those corresponding to the bins to use */
+	/* Extract the bin variables corresponding to the bins to use */
 
-	/* Allocate space for arrays of bin information */
-	
 	c->bin_nseg     = (short *) GMT_memory (VNULL, (size_t)nb, sizeof (short), "GMT_init_br");
 	c->bin_firstseg     = (int *) GMT_memory (VNULL, (size_t)nb, sizeof (int), "GMT_init_br");
 	
-	count[0] = c->n_bin;
-	stmp = (short *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (short), "GMT_init_br");
-	
-	check_nc_status (nc_get_vara_short (c->cdfid, c->bin_nseg_id, start, count, stmp));
-	for (i = 0; i < c->nb; i++) c->bin_nseg[i] = stmp[c->bins[i]];
-	GMT_free ((void *)stmp);
-	
-	itmp = (int *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (int), "GMT_init_br");
-	check_nc_status (nc_get_vara_int (c->cdfid, c->bin_firstseg_id, start, count, itmp));
-	for (i = 0; i < c->nb; i++) c->bin_firstseg[i] = itmp[c->bins[i]];
+	for (i = 0; i < c->nb; i++) {
+		c->bin_nseg[i] = db->br.bin_nseg[c->bins[i]];
+		c->bin_firstseg[i] = db->br.bin_firstseg[c->bins[i]];
+	}
 	
-	GMT_free ((void *)itmp);
+	if (db->br.bin_npt) {
+		c->bin_npt = (int *) GMT_memory (VNULL, (size_t)nb, sizeof (int), "GMT_init_br");
+		for (i = 0; i < c->nb; i++) c->bin_npt[i] = db->br.bin_npt[c->bins[i]];
+	}
 	
 	return (0);
 }
@@ -390,66 +581,27 @@ void GMT_get_br_bin (int b, struct GMT_BR *c, int *level, int n_levels)
 /* level: Levels of features to extract */
 /* n_levels: # of such levels. 0 means use all levels */
 {
-	size_t start[1], count[1];
-	int *seg_start;
-	short *seg_n, *seg_level;
-	int s, i, k, skip;
-	
 	c->lon_sw = (c->bins[b] % c->bin_nx) * c->bin_size / 60.0;
 	c->lat_sw = 90.0 - ((c->bins[b] / c->bin_nx) + 1) * c->bin_size / 60.0;
 	c->ns = c->bin_nseg[b];
+	c->cache = NULL;
+	c->arena = (short *)NULL;
 	
 	if (c->ns == 0) return;
 	
-	start[0] = c->bin_firstseg[b];
-	count[0] = c->bin_nseg[b];
-	
-	seg_n = (short *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (short), "GMT_get_br_bin");
-	seg_level = (short *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (short), "GMT_get_br_bin");
-	seg_start = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_br_bin");
-	
-	check_nc_status (nc_get_vara_short (c->cdfid, c->seg_n_id, start, count, seg_n));
-        check_nc_status (nc_get_vara_short (c->cdfid, c->seg_level_id, start, count, seg_level));
-        check_nc_status (nc_get_vara_int (c->cdfid, c->seg_start_id, start, count, seg_start));
-
-
-	c->seg = (struct GMT_BR_SEGMENT *) GMT_memory (VNULL, (size_t)c->ns, sizeof (struct GMT_BR_SEGMENT), "GMT_get_br_bin");
-	
-	for (s = i = 0; i < c->ns; i++) {
-		if (n_levels == 0)
-			skip = FALSE;
-		else {
-			for (k = 0, skip = TRUE; skip && k < n_levels; k++)
-				if (seg_level[i] == level[k]) skip = FALSE;
-		}
-		if (skip) continue;
-		
-		c->seg[s].n = seg_n[i];
-		c->seg[s].level = seg_level[i];
-		c->seg[s].dx = (short *) GMT_memory (VNULL, (size_t)c->seg[s].n, sizeof (short), "GMT_get_br_bin");
-		c->seg[s].dy = (short *) GMT_memory (VNULL, (size_t)c->seg[s].n, sizeof (short), "GMT_get_br_bin");
-		start[0] = seg_start[i];
-		count[0] = c->seg[s].n;
-		check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dx_id, start, count, c->seg[s].dx));
-                check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dy_id, start, count, c->seg[s].dy));
-
-		s++;
-	}
-	
-	c->ns = s;
-
-	GMT_free ((void *) seg_n);	
-	GMT_free ((void *) seg_level);	
-	GMT_free ((void *) seg_start);	
-	
+	GMT_shore_lock ();
+	GMT_br_read_bin (b, c, level, n_levels);
+	GMT_shore_unlock ();
 }
 
-int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN assemble, BOOLEAN shift, double west, double east, struct POL **pol)
+int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN assemble, BOOLEAN shift, double west, double east, struct POL **pol, struct GMT_ARENA *A)
                 
                      
 /* assemble: TRUE if polygons is needed */
 /* shift: TRUE if longitudes may have to be shifted */
 /* edge: Edge test for shifting */
+/* A: Arena the polygons come from, or NULL for GMT_memory (free with GMT_free_polygons) */
+/* c->straight: TRUE to join bin edges straight in lon/lat rather than along the map */
 
 {
 	struct POL *p;
@@ -460,14 +612,14 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 	
 	if (!assemble) {	/* Easy, just need to scale all segments to degrees and return */
 	
-		p = (struct POL *) GMT_memory (VNULL, (size_t)c->ns, sizeof (struct POL), "GMT_assemble_shore");
+		p = (struct POL *) GMT_arena_alloc (A, (size_t)c->ns, sizeof (struct POL));
 		
 		for (id = 0; id < c->ns; id++) {
-			p[id].lon = (double *) GMT_memory (VNULL, (size_t)c->seg[id].n, sizeof (double), "GMT_assemble_shore");
-			p[id].lat = (double *) GMT_memory (VNULL, (size_t)c->seg[id].n, sizeof (double), "GMT_assemble_shore");
+			p[id].lon = (double *) GMT_arena_alloc (A, (size_t)c->seg[id].n, sizeof (double));
+			p[id].lat = (double *) GMT_arena_alloc (A, (size_t)c->seg[id].n, sizeof (double));
 			p[id].n = GMT_copy_to_shore_path (p[id].lon, p[id].lat, c, id);
 			p[id].level = c->seg[id].level;
-			p[id].interior = FALSE;
+			p[id].interior = (c->seg[id].entry == 4);	/* Whole polygon within the bin */
 			GMT_shore_path_shift2 (p[id].lon, p[id].lat, p[id].n, west, east, c->leftmost_bin);
 		}
 	
@@ -488,12 +640,12 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 	shore_prepare_sides (c, dir);
 	
 	p_alloc = (c->ns == 0) ? 1 : GMT_SMALL_CHUNK;
-	p = (struct POL *) GMT_memory (VNULL, (size_t)p_alloc, sizeof (struct POL), "GMT_assemble_shore");
+	p = (struct POL *) GMT_arena_alloc (A, (size_t)p_alloc, sizeof (struct POL));
 	
 	low_level = MAX_LEVEL;
 	
 	if (completely_inside && use_this_level) {	/* Must include path of this bin outline as first polygon */
-		p[0].n = GMT_graticule_path (&p[0].lon, &p[0].lat, dir, c->lon_corner[3], c->lon_corner[1], c->lat_corner[0], c->lat_corner[2]);
+		p[0].n = GMT_graticule_path (&p[0].lon, &p[0].lat, dir, c->straight, c->lon_corner[3], c->lon_corner[1], c->lat_corner[0], c->lat_corner[2], A);
 		p[0].level = c->node_level[0];	/* Any corner will do */
 		p[0].interior = FALSE;
 		P = 1;
@@ -507,8 +659,8 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 		next_side = c->seg[id].exit;
 		
 		n_alloc = c->seg[id].n;
-		p[P].lon = (double *) GMT_memory (VNULL, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
-		p[P].lat = (double *) GMT_memory (VNULL, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
+		p[P].lon = (double *) GMT_arena_alloc (A, (size_t)n_alloc, sizeof (double));
+		p[P].lat = (double *) GMT_arena_alloc (A, (size_t)n_alloc, sizeof (double));
 		n = GMT_copy_to_shore_path (p[P].lon, p[P].lat, c, id);
 		if ((int)c->seg[id].level < low_level) low_level = (int)c->seg[id].level;
 		
@@ -521,10 +673,8 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 			if (id < 0) {	/* Corner */
 				cid = id + 4;
 				nid = (dir == 1) ? (cid + 1) % 4 : cid;
-				if ((add = GMT_map_path (p[P].lon[n-1], p[P].lat[n-1], c->lon_corner[cid], c->lat_corner[cid], &xtmp, &ytmp))) {
-					n_alloc += add;
-					p[P].lon = (double *) GMT_memory ((void *)p[P].lon, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
-					p[P].lat = (double *) GMT_memory ((void *)p[P].lat, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
+				if ((add = GMT_map_path (p[P].lon[n-1], p[P].lat[n-1], c->lon_corner[cid], c->lat_corner[cid], c->straight, &xtmp, &ytmp, A))) {
+					n_alloc = GMT_shore_grow_path (&p[P], n, n_alloc, add, A);
 					memcpy ((void *)&p[P].lon[n], (void *)xtmp, (size_t)(add * sizeof (double)));
 					memcpy ((void *)&p[P].lat[n], (void *)ytmp, (size_t)(add * sizeof (double)));
 					n += add;
@@ -534,10 +684,8 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 			}
 			else {
 				GMT_shore_to_degree (c, c->seg[id].dx[0], c->seg[id].dy[0], &plon, &plat);
-				if ((add = GMT_map_path (p[P].lon[n-1], p[P].lat[n-1], plon, plat, &xtmp, &ytmp))) {
-					n_alloc += add;
-					p[P].lon = (double *) GMT_memory ((void *)p[P].lon, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
-					p[P].lat = (double *) GMT_memory ((void *)p[P].lat, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
+				if ((add = GMT_map_path (p[P].lon[n-1], p[P].lat[n-1], plon, plat, c->straight, &xtmp, &ytmp, A))) {
+					n_alloc = GMT_shore_grow_path (&p[P], n, n_alloc, add, A);
 					memcpy ((void *)&p[P].lon[n], (void *)xtmp, (size_t)(add * sizeof (double)));
 					memcpy ((void *)&p[P].lat[n], (void *)ytmp, (size_t)(add * sizeof (double)));
 					n += add;
@@ -546,17 +694,15 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 				if (next_side == start_side && entry_pos == first_pos)
 					more = FALSE;
 				else {
-					n_alloc += c->seg[id].n;
-					p[P].lon = (double *) GMT_memory ((void *)p[P].lon, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
-					p[P].lat = (double *) GMT_memory ((void *)p[P].lat, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
+					n_alloc = GMT_shore_grow_path (&p[P], n, n_alloc, (int)c->seg[id].n, A);
 					n += GMT_copy_to_shore_path (&p[P].lon[n], &p[P].lat[n], c, id);
 					next_side = c->seg[id].exit;
 					if ((int)c->seg[id].level < low_level) low_level = (int)c->seg[id].level;
 				}
 			}
 			if (add) {
-				GMT_free ((void *)xtmp);
-				GMT_free ((void *)ytmp);
+				GMT_arena_release (A, (void *)xtmp);
+				GMT_arena_release (A, (void *)ytmp);
 			}
 		}
 		p[P].n = n;
@@ -564,8 +710,8 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 		p[P].level = (dir == 1) ? 2 * ((low_level - 1) / 2) + 1: 2 * (low_level/2);
 		P++;
 		if (P == p_alloc) {
+			p = (struct POL *) GMT_arena_grow (A, (void *)p, (size_t)p_alloc, (size_t)(p_alloc + GMT_SMALL_CHUNK), sizeof (struct POL));
 			p_alloc += GMT_SMALL_CHUNK;
-			p = (struct POL *) GMT_memory ((void *)p, (size_t)p_alloc, sizeof (struct POL), "GMT_assemble_shore");
 		}
 		
 	}
@@ -575,40 +721,468 @@ int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN a
 	for (id = 0; id < c->ns; id++) {
 		if (c->seg[id].entry < 4) continue;
 		n_alloc = c->seg[id].n;
-		p[P].lon = (double *) GMT_memory (VNULL, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
-		p[P].lat = (double *) GMT_memory (VNULL, (size_t)n_alloc, sizeof (double), "GMT_assemble_shore");
+		p[P].lon = (double *) GMT_arena_alloc (A, (size_t)n_alloc, sizeof (double));
+		p[P].lat = (double *) GMT_arena_alloc (A, (size_t)n_alloc, sizeof (double));
 		p[P].n = GMT_copy_to_shore_path (p[P].lon, p[P].lat, c, id);
 		p[P].interior = TRUE;
 		p[P].level = c->seg[id].level;
 		P++;
 		if (P == p_alloc) {
+			p = (struct POL *) GMT_arena_grow (A, (void *)p, (size_t)p_alloc, (size_t)(p_alloc + GMT_SMALL_CHUNK), sizeof (struct POL));
 			p_alloc += GMT_SMALL_CHUNK;
-			p = (struct POL *) GMT_memory ((void *)p, (size_t)p_alloc, sizeof (struct POL), "GMT_assemble_shore");
 		}
 	}
 	
 	GMT_shore_pau_sides (c);
 
-	if (c->ns > 0) p = (struct POL *) GMT_memory ((void *)p, (size_t)P, sizeof (struct POL), "GMT_assemble_shore");
+	if (c->ns > 0 && !A) p = (struct POL *) GMT_memory ((void *)p, (size_t)P, sizeof (struct POL), "GMT_assemble_shore");
 	
 	for (id = 0; id < P; id++) GMT_shore_path_shift2 (p[id].lon, p[id].lat, p[id].n, west, east, c->leftmost_bin);
 
 	*pol = p;
 	return (P);
 }
+
+int GMT_shore_grow_path (struct POL *p, int n, int n_alloc, int add, struct GMT_ARENA *A)
+{
+	/* Makes room for add more points after the n of the open path p, doubling
+	 * its allocation so a path joined from many pieces is copied only a few
+	 * times.  Returns the new allocation */
+
+	int new_alloc;
+
+	if (n + add <= n_alloc) return (n_alloc);
+	new_alloc = MAX (2 * n_alloc, n + add);
+	p->lon = (double *) GMT_arena_grow (A, (void *)p->lon, (size_t)n_alloc, (size_t)new_alloc, sizeof (double));
+	p->lat = (double *) GMT_arena_grow (A, (void *)p->lat, (size_t)n_alloc, (size_t)new_alloc, sizeof (double));
+	return (new_alloc);
+}
 		
-int GMT_assemble_br (struct GMT_BR *c, BOOLEAN shift, double edge, struct POL **pol)
-/* shift: TRUE if longitudes may have to be shifted */
-/* edge: Edge test for shifting */       
+int GMT_merge_shore (struct POL *p, int np, int dir, int first_level, int corner_level, struct GMT_SHORE_OUTLINE *B, struct POL **pol)
+/* p: Open pieces of many bins, as GMT_assemble_shore gives them with assemble = FALSE */
+/* dir: 1 for land, -1 for water, 0 for both */
+/* first_level: Lowest level wanted */
+/* corner_level: Level at the SW corner of B, which decides what is inside where no shoreline crosses B */
+/* B: Bin-aligned region the bins tile */
 {
-	struct POL *p;
-	int id;
+	/* Joins the pieces into one closed ring per polygon.  A piece goes on
+	 * where another one of the same level stops on a bin edge, and polygons
+	 * cut by B are closed along its outline with the odd (dry) side to the
+	 * left of the shoreline, as GMT_assemble_shore does within one bin.
+	 * Land gives the rings of levels 1 and up; water the ocean (level 0)
+	 * right of the level 1 shorelines, the level 1 rings that are whole
+	 * (islands) and levels 2 and up.  Painted in order, odd levels dry and
+	 * even levels wet, they make the map.  Returns the number of rings,
+	 * sorted on level; free them with GMT_free_polygons */
+
+	int i, k, L, nh, nc, n_loop, n_ring, c_alloc, l_alloc, r_alloc, n_alloc, *head, *next, *used;
+	double *t_in, *t_out;
+	struct POL *chain, *loop, *ring, r;
+
+	nh = 256;
+	while (nh < 2 * np) nh *= 2;
+	head = (int *) GMT_memory (VNULL, (size_t)nh, sizeof (int), "GMT_merge_shore");
+	next = (int *) GMT_memory (VNULL, (size_t)(np + 1), sizeof (int), "GMT_merge_shore");
+	used = (int *) GMT_memory (VNULL, (size_t)(np + 1), sizeof (int), "GMT_merge_shore");
+	for (k = 0; k < nh; k++) head[k] = -1;
+	for (i = 0; i < np; i++) {	/* Hash the first point of every open piece */
+		if ((used[i] = (p[i].interior || p[i].n < 2))) continue;
+		k = GMT_shore_key (p[i].lon[0], p[i].lat[0], B, nh);
+		next[i] = head[k];
+		head[k] = i;
+	}
+
+	nc = c_alloc = n_loop = l_alloc = 0;
+	chain = loop = (struct POL *)NULL;
+	t_in = t_out = (double *)NULL;
+
+	for (i = 0; i < np; i++) {	/* A piece coming in across the outline starts a chain */
+		if (used[i] || GMT_shore_outline_pos (B, p[i].lon[0], p[i].lat[0]) < 0.0) continue;
+		memset ((void *)&r, 0, sizeof (struct POL));
+		r.level = p[i].level;
+		for (k = i, n_alloc = 0; k >= 0; k = GMT_shore_next_piece (p, head, next, used, k, B, nh)) {
+			n_alloc = GMT_shore_ring_add (&r, n_alloc, p[k].lon, p[k].lat, p[k].n, FALSE, B->tol);
+			used[k] = TRUE;
+			if (GMT_shore_outline_pos (B, r.lon[r.n-1], r.lat[r.n-1]) >= 0.0) break;	/* Out again */
+		}
+		if (nc == c_alloc) {
+			c_alloc += GMT_SMALL_CHUNK;
+			chain = (struct POL *) GMT_memory ((void *)chain, (size_t)c_alloc, sizeof (struct POL), "GMT_merge_shore");
+			t_in = (double *) GMT_memory ((void *)t_in, (size_t)c_alloc, sizeof (double), "GMT_merge_shore");
+			t_out = (double *) GMT_memory ((void *)t_out, (size_t)c_alloc, sizeof (double), "GMT_merge_shore");
+		}
+		chain[nc] = r;
+		t_in[nc] = GMT_shore_outline_pos (B, r.lon[0], r.lat[0]);
+		t_out[nc] = GMT_shore_outline_pos (B, r.lon[r.n-1], r.lat[r.n-1]);
+		if (t_out[nc] < 0.0) {	/* Lost its way; keep it as it is */
+			r.interior = FALSE;
+			n_loop = GMT_shore_push_ring (&loop, n_loop, &l_alloc, &r);
+		}
+		else
+			nc++;
+	}
+
+	for (i = 0; i < np; i++) {	/* The other pieces make polygons that are whole within B */
+		if (used[i]) continue;
+		memset ((void *)&r, 0, sizeof (struct POL));
+		r.level = p[i].level;
+		for (k = i, n_alloc = 0; k >= 0; k = GMT_shore_next_piece (p, head, next, used, k, B, nh)) {
+			n_alloc = GMT_shore_ring_add (&r, n_alloc, p[k].lon, p[k].lat, p[k].n, FALSE, B->tol);
+			used[k] = TRUE;
+			if (r.n > 2 && fabs (r.lon[r.n-1] - r.lon[0]) < B->tol && fabs (r.lat[r.n-1] - r.lat[0]) < B->tol) break;
+		}
+		r.interior = (k >= 0);	/* FALSE if no piece went on from the last one */
+		n_loop = GMT_shore_push_ring (&loop, n_loop, &l_alloc, &r);
+	}
+	for (i = 0; i < np; i++) {	/* And so do the polygons inside one bin */
+		if (!p[i].interior || p[i].n < 2) continue;
+		memset ((void *)&r, 0, sizeof (struct POL));
+		r.level = p[i].level;
+		r.interior = TRUE;
+		GMT_shore_ring_add (&r, 0, p[i].lon, p[i].lat, p[i].n, FALSE, B->tol);
+		n_loop = GMT_shore_push_ring (&loop, n_loop, &l_alloc, &r);
+	}
+
+	n_ring = r_alloc = 0;
+	ring = (struct POL *)NULL;
+	for (L = MAX (first_level, 0); L <= MAX_LEVEL; L++) {
+		if (L == 0 && dir == 1) continue;
+		if (L == 0)	/* Ocean is on the wet side of the level 1 shorelines */
+			n_ring = GMT_shore_close_chains (chain, t_in, t_out, nc, 1, TRUE, 0, (corner_level == 0), B, &ring, n_ring, &r_alloc);
+		else if (L > 1 || dir != -1)
+			n_ring = GMT_shore_close_chains (chain, t_in, t_out, nc, L, FALSE, L, (corner_level >= L), B, &ring, n_ring, &r_alloc);
+		for (i = 0; i < n_loop; i++) {
+			if (loop[i].level != L) continue;
+			n_ring = GMT_shore_push_ring (&ring, n_ring, &r_alloc, &loop[i]);
+			loop[i].lon = loop[i].lat = (double *)NULL;
+		}
+	}
+
+	for (i = 0; i < n_loop; i++) if (loop[i].lon) {	/* Levels that were not wanted */
+		GMT_free ((void *)loop[i].lon);
+		GMT_free ((void *)loop[i].lat);
+	}
+	GMT_free_polygons (chain, nc);
+	if (chain) {
+		GMT_free ((void *)chain);
+		GMT_free ((void *)t_in);
+		GMT_free ((void *)t_out);
+	}
+	if (loop) GMT_free ((void *)loop);
+	GMT_free ((void *)head);
+	GMT_free ((void *)next);
+	GMT_free ((void *)used);
+
+	*pol = ring;
+	return (n_ring);
+}
+
+int GMT_shore_close_chains (struct POL *chain, double *t_in, double *t_out, int nc, int level, BOOLEAN reverse, int new_level, BOOLEAN whole, struct GMT_SHORE_OUTLINE *B, struct POL **ring, int n_ring, int *r_alloc)
+{
+	/* Closes the chains of one level into rings of new_level and adds them
+	 * to ring.  The inside of a ring is left of its chains, which are
+	 * reversed to get the even side of odd levels and the other way round,
+	 * so from where a chain goes out the outline is followed
+	 * counterclockwise (odd levels) or clockwise (even levels) to where the
+	 * next one comes in.  If no chain crosses the outline it is a ring of
+	 * its own when whole is TRUE.  Returns the new number of rings */
+
+	int i, j, k, walk, n_alloc, n_use, *done;
+	double t, d, d_min;
+	struct POL r;
+
+	walk = (level % 2) ? 1 : -1;
+	for (i = n_use = 0; i < nc; i++) if (chain[i].level == level) n_use++;
+
+	if (n_use == 0) {
+		if (!whole) return (n_ring);
+		memset ((void *)&r, 0, sizeof (struct POL));
+		r.level = new_level;
+		n_alloc = GMT_shore_ring_add (&r, 0, &B->w, &B->s, 1, FALSE, B->tol);	/* The SW corner */
+		n_alloc = GMT_shore_ring_walk (&r, n_alloc, B, 0.0, B->perimeter, 1);
+		return (GMT_shore_push_ring (ring, n_ring, r_alloc, &r));
+	}
+
+	done = (int *) GMT_memory (VNULL, (size_t)nc, sizeof (int), "GMT_shore_close_chains");
+	for (i = 0; i < nc; i++) {
+		if (done[i] || chain[i].level != level) continue;
+		memset ((void *)&r, 0, sizeof (struct POL));
+		r.level = new_level;
+		n_alloc = 0;
+		k = i;
+		do {
+			n_alloc = GMT_shore_ring_add (&r, n_alloc, chain[k].lon, chain[k].lat, chain[k].n, reverse, B->tol);
+			done[k] = TRUE;
+			t = (reverse) ? t_in[k] : t_out[k];	/* Where it leaves */
+			for (j = 0, k = -1, d_min = 2.0 * B->perimeter; j < nc; j++) {	/* The next one in along the outline */
+				if (chain[j].level != level) continue;
+				d = walk * (((reverse) ? t_out[j] : t_in[j]) - t);
+				if (d < -B->tol)
+					d += B->perimeter;
+				else if (d < 0.0)
+					d = 0.0;
+				if (d < d_min) {
+					d_min = d;
+					k = j;
+				}
+			}
+			n_alloc = GMT_shore_ring_walk (&r, n_alloc, B, t, d_min, walk);
+		} while (!done[k]);
+		n_ring = GMT_shore_push_ring (ring, n_ring, r_alloc, &r);
+	}
+	GMT_free ((void *)done);
+
+	return (n_ring);
+}
+
+int GMT_shore_next_piece (struct POL *p, int *head, int *next, int *used, int k, struct GMT_SHORE_OUTLINE *B, int nh)
+{
+	/* Returns the unused piece of the same level that starts where piece k ends, or -1 */
+
+	int j, n;
+
+	n = p[k].n - 1;
+	for (j = head[GMT_shore_key (p[k].lon[n], p[k].lat[n], B, nh)]; j >= 0; j = next[j]) {
+		if (used[j] || p[j].level != p[k].level) continue;
+		if (fabs (p[j].lon[0] - p[k].lon[n]) < B->tol && fabs (p[j].lat[0] - p[k].lat[n]) < B->tol) return (j);
+	}
+	return (-1);
+}
+
+int GMT_shore_key (double lon, double lat, struct GMT_SHORE_OUTLINE *B, int nh)
+{
+	/* Hash of a point rounded to the data resolution (2 * B->tol), nh a power of 2 */
+
+	unsigned long ix, iy;
+
+	ix = (unsigned long)floor ((lon - B->w) / (2.0 * B->tol) + 0.5);
+	iy = (unsigned long)floor ((lat - B->s) / (2.0 * B->tol) + 0.5);
+	return ((int)(((ix * 73856093UL) ^ (iy * 19349663UL)) & (unsigned long)(nh - 1)));
+}
+
+double GMT_shore_outline_pos (struct GMT_SHORE_OUTLINE *B, double lon, double lat)
+{
+	/* Distance counterclockwise along the outline of B from its SW corner,
+	 * or -1 if the point is not on the outline */
+
+	double t;
+
+	if (fabs (lat - B->s) < B->tol)
+		t = lon - B->w;
+	else if (fabs (lon - B->e) < B->tol)
+		t = B->width + lat - B->s;
+	else if (fabs (lat - B->n) < B->tol)
+		t = B->width + B->height + B->e - lon;
+	else if (fabs (lon - B->w) < B->tol)
+		t = 2.0 * B->width + B->height + B->n - lat;
+	else
+		return (-1.0);
+	if (t < 0.0 || t > B->perimeter - B->tol) t = 0.0;	/* The SW corner */
+	return (t);
+}
+
+int GMT_shore_ring_walk (struct POL *r, int n_alloc, struct GMT_SHORE_OUTLINE *B, double t0, double d, int walk)
+{
+	/* Adds the points of the outline every B->step (corners included) that
+	 * are more than 0 and less than d away from t0 in the walk direction.
+	 * Returns the new allocation of r */
+
+	int m;
+	double t, u;
+
+	m = (walk == 1) ? (int)floor (t0 / B->step + 1.0e-9) + 1 : (int)ceil (t0 / B->step - 1.0e-9) - 1;
+	for (t = m * B->step; walk * (t - t0) < d - B->tol; m += walk, t = m * B->step) {
+		u = fmod (t, B->perimeter);
+		if (u < 0.0) u += B->perimeter;
+		if (r->n == n_alloc) n_alloc = GMT_shore_grow_path (r, r->n, n_alloc, GMT_SMALL_CHUNK, (struct GMT_ARENA *)NULL);
+		if (u < B->width) {
+			r->lon[r->n] = B->w + u;
+			r->lat[r->n] = B->s;
+		}
+		else if (u < B->width + B->height) {
+			r->lon[r->n] = B->e;
+			r->lat[r->n] = B->s + u - B->width;
+		}
+		else if (u < 2.0 * B->width + B->height) {
+			r->lon[r->n] = B->e - (u - B->width - B->height);
+			r->lat[r->n] = B->n;
+		}
+		else {
+			r->lon[r->n] = B->w;
+			r->lat[r->n] = B->n - (u - 2.0 * B->width - B->height);
+		}
+		r->n++;
+	}
+	return (n_alloc);
+}
+
+int GMT_shore_ring_add (struct POL *r, int n_alloc, double *lon, double *lat, int n, BOOLEAN reverse, double tol)
+{
+	/* Appends a path to r, backwards if reverse, dropping points that repeat
+	 * the last one.  Returns the new allocation of r */
+
+	int i, k;
+
+	for (i = 0; i < n; i++) {
+		k = (reverse) ? n - 1 - i : i;
+		if (r->n && fabs (r->lon[r->n-1] - lon[k]) < tol && fabs (r->lat[r->n-1] - lat[k]) < tol) continue;
+		if (r->n == n_alloc) n_alloc = GMT_shore_grow_path (r, r->n, n_alloc, n - i, (struct GMT_ARENA *)NULL);
+		r->lon[r->n] = lon[k];
+		r->lat[r->n] = lat[k];
+		r->n++;
+	}
+	return (n_alloc);
+}
+
+int GMT_shore_push_ring (struct POL **ring, int n_ring, int *r_alloc, struct POL *r)
+{
+	/* Closes r if need be and adds it to ring, or frees it if it has no area.
+	 * Returns the new number of rings */
+
+	if (r->n > 0 && (r->lon[r->n-1] != r->lon[0] || r->lat[r->n-1] != r->lat[0])) {
+		r->lon = (double *) GMT_memory ((void *)r->lon, (size_t)(r->n + 1), sizeof (double), "GMT_shore_push_ring");
+		r->lat = (double *) GMT_memory ((void *)r->lat, (size_t)(r->n + 1), sizeof (double), "GMT_shore_push_ring");
+		r->lon[r->n] = r->lon[0];
+		r->lat[r->n] = r->lat[0];
+		r->n++;
+	}
+	if (r->n < 4) {
+		if (r->lon) {
+			GMT_free ((void *)r->lon);
+			GMT_free ((void *)r->lat);
+		}
+		return (n_ring);
+	}
+	if (n_ring == *r_alloc) {
+		*r_alloc += GMT_SMALL_CHUNK;
+		*ring = (struct POL *) GMT_memory ((void *)*ring, (size_t)*r_alloc, sizeof (struct POL), "GMT_shore_push_ring");
+	}
+	(*ring)[n_ring] = *r;
+	return (n_ring + 1);
+}
+
+int GMT_stitch_lines (struct POL *p, int np, struct GMT_SHORE_OUTLINE *B, struct POL **line, double **xy)
+/* p: Lines of many bins, as GMT_assemble_shore (assemble = FALSE) or GMT_assemble_br give them */
+/* B: Bin-aligned region the bins tile; only w, s, step (the bin size) and tol are used */
+{
+	/* Joins the lines into continuous ones.  Two ends are joined where they
+	 * are the only two ends of that level at a point on a bin edge; where
+	 * more meet, lines cross there and are left alone.  A line is followed
+	 * in its own direction where it can be, so shorelines keep their dry
+	 * side to the left.  The coordinates of all lines end up in one block,
+	 * *xy, to be freed with *line.  Returns the number of lines */
+
+	int i, k, e, f, g, n_meet, nh, pass, n_line, l_alloc, n_alloc, *head, *next, *link, *used;
+	size_t n_xy, off;
+	double x, y, x2, y2;
+	BOOLEAN reverse;
+	struct POL *L, r;
+
+	*line = (struct POL *)NULL;
+	*xy = (double *)NULL;
+	if (np == 0) return (0);
+
+	nh = 256;
+	while (nh < 4 * np) nh *= 2;
+	head = (int *) GMT_memory (VNULL, (size_t)nh, sizeof (int), "GMT_stitch_lines");
+	next = (int *) GMT_memory (VNULL, (size_t)(2 * np), sizeof (int), "GMT_stitch_lines");
+	link = (int *) GMT_memory (VNULL, (size_t)(2 * np), sizeof (int), "GMT_stitch_lines");
+	used = (int *) GMT_memory (VNULL, (size_t)np, sizeof (int), "GMT_stitch_lines");
+	for (k = 0; k < nh; k++) head[k] = -1;
+	for (e = 0; e < 2 * np; e++) {	/* End e is the first (even) or last (odd) point of line e/2 */
+		link[e] = next[e] = -1;
+		if (!GMT_stitch_end (p, e, B, &x, &y)) continue;
+		k = GMT_shore_key (x, y, B, nh);
+		next[e] = head[k];
+		head[k] = e;
+	}
+	for (e = 0; e < 2 * np; e++) {	/* Pair off the ends that meet no other */
+		if (!GMT_stitch_end (p, e, B, &x, &y)) continue;
+		for (f = head[GMT_shore_key (x, y, B, nh)], n_meet = 0, g = -1; f >= 0; f = next[f]) {
+			if (f == e) continue;
+			GMT_stitch_end (p, f, B, &x2, &y2);
+			if (fabs (x2 - x) >= B->tol || fabs (y2 - y) >= B->tol) continue;
+			n_meet++;
+			g = f;
+		}
+		if (n_meet == 1 && p[g/2].level == p[e/2].level) link[e] = g;
+	}
+
+	/* Lines are followed from an end that is not joined, their first point
+	 * if possible, then from their last; what is left are closed loops */
+
+	n_line = l_alloc = 0;
+	n_xy = 0;
+	L = (struct POL *)NULL;
+	for (pass = 0; pass < 3; pass++) for (i = 0; i < np; i++) {
+		if (used[i] || (pass == 0 && link[2*i] >= 0) || (pass == 1 && link[2*i+1] >= 0)) continue;
+		memset ((void *)&r, 0, sizeof (struct POL));
+		r.level = p[i].level;
+		for (k = i, reverse = (pass == 1), n_alloc = 0; k >= 0 && !used[k];) {
+			n_alloc = GMT_shore_ring_add (&r, n_alloc, p[k].lon, p[k].lat, p[k].n, reverse, B->tol);
+			used[k] = TRUE;
+			f = link[2*k + !reverse];	/* The end we leave by */
+			k = (f >= 0) ? f / 2 : -1;
+			reverse = (f & 1);	/* Came in at its last point */
+		}
+		if (r.n == 0) continue;
+		if (n_line == l_alloc) {
+			l_alloc += GMT_SMALL_CHUNK;
+			L = (struct POL *) GMT_memory ((void *)L, (size_t)l_alloc, sizeof (struct POL), "GMT_stitch_lines");
+		}
+		L[n_line++] = r;
+		n_xy += r.n;
+	}
+
+	*xy = (double *) GMT_memory (VNULL, 2 * n_xy, sizeof (double), "GMT_stitch_lines");
+	for (i = 0, off = 0; i < n_line; off += L[i].n, i++) {	/* All lon first, then all lat */
+		memcpy ((void *)&(*xy)[off], (void *)L[i].lon, (size_t)L[i].n * sizeof (double));
+		memcpy ((void *)&(*xy)[n_xy+off], (void *)L[i].lat, (size_t)L[i].n * sizeof (double));
+		GMT_free ((void *)L[i].lon);
+		GMT_free ((void *)L[i].lat);
+		L[i].lon = &(*xy)[off];
+		L[i].lat = &(*xy)[n_xy+off];
+	}
+
+	GMT_free ((void *)head);
+	GMT_free ((void *)next);
+	GMT_free ((void *)link);
+	GMT_free ((void *)used);
+
+	*line = L;
+	return (n_line);
+}
+
+BOOLEAN GMT_stitch_end (struct POL *p, int e, struct GMT_SHORE_OUTLINE *B, double *lon, double *lat)
+{
+	/* Gets end e of line e/2, and returns TRUE if it lies on a bin edge */
+
+	int k;
+	double d;
+
+	k = e / 2;
+	if (p[k].n < 2) return (FALSE);
+	*lon = p[k].lon[(e & 1) ? p[k].n - 1 : 0];
+	*lat = p[k].lat[(e & 1) ? p[k].n - 1 : 0];
+	d = (*lon - B->w) / B->step;
+	if (fabs (d - floor (d + 0.5)) * B->step < B->tol) return (TRUE);
+	d = (*lat - B->s) / B->step;
+	return (fabs (d - floor (d + 0.5)) * B->step < B->tol);
+}
+
+int GMT_assemble_br (struct GMT_BR *c, BOOLEAN shift, double edge, struct POL **pol, struct GMT_ARENA *A)
+/* shift: TRUE if longitudes may have to be shifted */
+/* edge: Edge test for shifting */       
+/* A: Arena the lines come from, or NULL for GMT_memory (free with GMT_free_polygons) */
+{
+	struct POL *p;
+	int id;
 	
-	p = (struct POL *) GMT_memory (VNULL, (size_t)c->ns, sizeof (struct POL), "GMT_assemble_br");
+	p = (struct POL *) GMT_arena_alloc (A, (size_t)c->ns, sizeof (struct POL));
 	
 	for (id = 0; id < c->ns; id++) {
-		p[id].lon = (double *) GMT_memory (VNULL, (size_t)c->seg[id].n, sizeof (double), "GMT_assemble_br");
-		p[id].lat = (double *) GMT_memory (VNULL, (size_t)c->seg[id].n, sizeof (double), "GMT_assemble_br");
+		p[id].lon = (double *) GMT_arena_alloc (A, (size_t)c->seg[id].n, sizeof (double));
+		p[id].lat = (double *) GMT_arena_alloc (A, (size_t)c->seg[id].n, sizeof (double));
 		p[id].n = GMT_copy_to_br_path (p[id].lon, p[id].lat, c, id);
 		p[id].level = c->seg[id].level;
 		if (shift) GMT_shore_path_shift (p[id].lon, p[id].lat, p[id].n, edge);
@@ -620,47 +1194,1387 @@ int GMT_assemble_br (struct GMT_BR *c, BOOLEAN shift, double edge, struct POL **
 		
 void GMT_free_shore (struct GMT_SHORE *c)
 {	/* Removes allocated variables for this block only */
-	int i;
-	
-	for (i = 0; i < c->ns; i++) {
-		GMT_free ((void *)c->seg[i].dx);
-		GMT_free ((void *)c->seg[i].dy);
+	if (c->cache) {	/* Segments belong to the bin cache */
+		GMT_shore_lock ();
+		GMT_bin_cache_release (c->cache);
+		GMT_shore_unlock ();
+		c->cache = NULL;
+		return;
 	}
+	if (c->arena) GMT_free ((void *)c->arena);	/* Mapped points have no arena */
 	if (c->ns) GMT_free ((void *)c->seg);
 }
 		
 void GMT_free_br (struct GMT_BR *c)
 {	/* Removes allocated variables for this block only */
-	int i;
-	
-	for (i = 0; i < c->ns; i++) {
-		GMT_free ((void *)c->seg[i].dx);
-		GMT_free ((void *)c->seg[i].dy);
+	if (c->cache) {	/* Segments belong to the bin cache */
+		GMT_shore_lock ();
+		GMT_bin_cache_release (c->cache);
+		GMT_shore_unlock ();
+		c->cache = NULL;
+		return;
 	}
+	if (c->arena) GMT_free ((void *)c->arena);	/* Mapped points have no arena */
 	if (c->ns) GMT_free ((void *)c->seg);
 }
 		
 void GMT_shore_cleanup (struct GMT_SHORE *c)
-{
+{	/* The netcdf file and bin_used stay with the database cache */
 	GMT_free ((void *)c->bins);
 	GMT_free ((void *)c->bin_info);
 	GMT_free ((void *)c->bin_nseg);
 	GMT_free ((void *)c->bin_firstseg);
-	check_nc_status (nc_close (c->cdfid));
+	if (c->bin_npt) GMT_free ((void *)c->bin_npt);
+	GMT_shore_drop_db (c->db);
+	c->db = (struct GMT_SHORE_DB *)NULL;
 }
 
 void GMT_br_cleanup (struct GMT_BR *c)
-{
+{	/* The netcdf file and bin_used stay with the database cache */
 	GMT_free ((void *)c->bins);
 	GMT_free ((void *)c->bin_nseg);
 	GMT_free ((void *)c->bin_firstseg);
-        check_nc_status (nc_close (c->cdfid)); 
+	if (c->bin_npt) GMT_free ((void *)c->bin_npt);
+	GMT_shore_drop_db (c->db);
+	c->db = (struct GMT_SHORE_DB *)NULL;
+}
+
+void GMT_shore_drop_db (struct GMT_SHORE_DB *db)
+{	/* A reader of db is done with it; closes db if it was flushed and this was its last reader */
+	if (!db) return;
+	GMT_shore_lock ();
+	if (--db->n_readers == 0 && db->flushed) GMT_shore_close_db (db);
+	GMT_shore_unlock ();
+}
+
+long GMT_shore_cache_size (long bytes)
+{
+	/* Sets the memory budget for decoded bins and returns the previous one.
+	 * A budget of 0 turns bin caching off; a negative value just queries */
+	 
+	long old;
+	
+	GMT_shore_lock ();
+	old = GMT_bin_cache_budget;
+	if (bytes >= 0) {
+		GMT_bin_cache_budget = bytes;
+		GMT_bin_cache_trim ();
+	}
+	GMT_shore_unlock ();
+	return (old);
+}
+
+void GMT_shore_cache_stats (long stats[4])
+{
+	GMT_shore_lock ();
+	stats[0] = GMT_bin_cache_hits;
+	stats[1] = GMT_bin_cache_misses;
+	stats[2] = GMT_bin_cache_bytes;
+	stats[3] = GMT_bin_cache_n;
+	GMT_shore_unlock ();
+}
+
+void GMT_shore_cache_flush (void)
+{
+	/* Releases all cached bins and closes all databases.  Bins and databases
+	 * that readers still use are only marked; the bins go when released and
+	 * the databases with their last reader, and nobody else gets them again */
+	 
+	struct GMT_SHORE_DB *db;
+	struct GMT_BIN_CACHE *e, *next;
+	
+	GMT_shore_lock ();
+	for (e = GMT_bin_lru_head; e; e = next) {
+		next = e->next;
+		if (e->n_users == 0)
+			GMT_bin_cache_evict (e);
+		else
+			e->stale = TRUE;
+	}
+	
+	while ((db = GMT_shore_db)) {
+		GMT_shore_db = db->next;
+		if (db->n_readers == 0)
+			GMT_shore_close_db (db);
+		else
+			db->flushed = TRUE;
+	}
+	GMT_shore_unlock ();
+}
+
+void GMT_shore_close_db (struct GMT_SHORE_DB *db)
+{
+	/* Frees the bin arrays of a database no reader uses any more and closes
+	 * or unmaps its files.  Caller must hold the shore lock */
+	 
+	if (db->kind == 'c') {
+		GMT_free ((void *)db->shore.bin_info);
+		GMT_free ((void *)db->shore.bin_nseg);
+		GMT_free ((void *)db->shore.bin_firstseg);
+		if (db->shore.bin_npt) GMT_free ((void *)db->shore.bin_npt);
+		if (db->shore.bin_used) GMT_free ((void *)db->shore.bin_used);
+		if (db->shore.rank_map) GMT_shore_unmap (db->shore.rank_map, db->shore.rank_map_size);
+		if (db->shore.map)
+			GMT_shore_unmap (db->shore.map, db->shore.map_size);
+		else
+			check_nc_status (nc_close (db->shore.cdfid));
+	}
+	else {
+		GMT_free ((void *)db->br.bin_nseg);
+		GMT_free ((void *)db->br.bin_firstseg);
+		if (db->br.bin_npt) GMT_free ((void *)db->br.bin_npt);
+		if (db->br.bin_used) GMT_free ((void *)db->br.bin_used);
+		if (db->br.rank_map) GMT_shore_unmap (db->br.rank_map, db->br.rank_map_size);
+		if (db->br.map)
+			GMT_shore_unmap (db->br.map, db->br.map_size);
+		else
+			check_nc_status (nc_close (db->br.cdfid));
+	}
+	GMT_free ((void *)db);
+}
+
+
+int GMT_shore_convert (char kind, char res, char *file)
+{
+	/* Writes the netcdf database of the given kind (c, b, r) and resolution to file in the
+	 * compact format that GMT_init_shore and GMT_init_br will map instead if it is present */
+	 
+	int i, n, n_bin, n_seg, *seg_info, *seg_area, *seg_start, *bin_firstseg;
+	short *bin_info, *bin_nseg, *seg_n, *seg_level, *pt_dx, *pt_dy;
+	char name[32], path[BUFSIZ];
+	size_t start[1], count[1];
+	FILE *fp;
+	struct GMT_SHORE c;
+	struct GMT_BR r;
+	struct GMT_SHORE_FILE_HEADER h;
+	struct GMT_SHORE_FILE_BIN bin;
+	struct GMT_SHORE_FILE_SEG seg;
+	
+	GMT_shore_file_name (kind, res, "cdf", name);
+	if (!GMT_getpathname (name, path)) {
+		fprintf (stderr, "%s: Cannot find %s\n", GMT_program, name);
+		return (-1);
+	}
+	if ((fp = fopen (file, "wb")) == NULL) {
+		fprintf (stderr, "%s: Cannot create %s\n", GMT_program, file);
+		return (-1);
+	}
+	
+	memset ((void *)&h, 0, sizeof (struct GMT_SHORE_FILE_HEADER));
+	memcpy ((void *)h.magic, (void *)GMT_SHORE_MAGIC, (size_t)8);
+	h.version = GMT_SHORE_VERSION;
+	h.byte_order = GMT_SHORE_BYTE_ORDER;
+	h.kind = kind;
+	start[0] = 0;
+	
+	GMT_shore_lock ();	/* The netcdf library is not reentrant */
+	if (kind == 'c') {
+		GMT_shore_read_header (&c, path);
+		h.bin_size = c.bin_size;	h.bin_nx = c.bin_nx;	h.bin_ny = c.bin_ny;
+		n_bin = h.n_bin = c.n_bin;	n_seg = h.n_seg = c.n_seg;
+		memcpy ((void *)h.units, (void *)c.units, (size_t)80);
+		memcpy ((void *)h.title, (void *)c.title, (size_t)80);
+		memcpy ((void *)h.source, (void *)c.source, (size_t)80);
+		bin_info = c.bin_info;	bin_nseg = c.bin_nseg;	bin_firstseg = c.bin_firstseg;
+		
+		seg_info = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_convert");
+		seg_area = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_convert");
+		seg_start = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_convert");
+		pt_dx = (short *) GMT_memory (VNULL, (size_t)c.n_pt, sizeof (short), "GMT_shore_convert");
+		pt_dy = (short *) GMT_memory (VNULL, (size_t)c.n_pt, sizeof (short), "GMT_shore_convert");
+		
+		count[0] = n_seg;
+		check_nc_status (nc_get_vara_int (c.cdfid, c.seg_info_id, start, count, seg_info));
+		check_nc_status (nc_get_vara_int (c.cdfid, c.seg_area_id, start, count, seg_area));
+		check_nc_status (nc_get_vara_int (c.cdfid, c.seg_start_id, start, count, seg_start));
+		count[0] = c.n_pt;
+		check_nc_status (nc_get_vara_short (c.cdfid, c.pt_dx_id, start, count, pt_dx));
+		check_nc_status (nc_get_vara_short (c.cdfid, c.pt_dy_id, start, count, pt_dy));
+		check_nc_status (nc_close (c.cdfid));
+	}
+	else {
+		GMT_br_read_header (&r, path);
+		h.bin_size = r.bin_size;	h.bin_nx = r.bin_nx;	h.bin_ny = r.bin_ny;
+		n_bin = h.n_bin = r.n_bin;	n_seg = h.n_seg = r.n_seg;
+		memcpy ((void *)h.units, (void *)r.units, (size_t)80);
+		memcpy ((void *)h.title, (void *)r.title, (size_t)80);
+		memcpy ((void *)h.source, (void *)r.source, (size_t)80);
+		bin_info = (short *)NULL;	bin_nseg = r.bin_nseg;	bin_firstseg = r.bin_firstseg;
+		
+		seg_n = (short *) GMT_memory (VNULL, (size_t)n_seg, sizeof (short), "GMT_shore_convert");
+		seg_level = (short *) GMT_memory (VNULL, (size_t)n_seg, sizeof (short), "GMT_shore_convert");
+		seg_info = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_convert");
+		seg_area = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_convert");
+		seg_start = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_convert");
+		pt_dx = (short *) GMT_memory (VNULL, (size_t)r.n_pt, sizeof (short), "GMT_shore_convert");
+		pt_dy = (short *) GMT_memory (VNULL, (size_t)r.n_pt, sizeof (short), "GMT_shore_convert");
+		
+		count[0] = n_seg;
+		check_nc_status (nc_get_vara_short (r.cdfid, r.seg_n_id, start, count, seg_n));
+		check_nc_status (nc_get_vara_short (r.cdfid, r.seg_level_id, start, count, seg_level));
+		check_nc_status (nc_get_vara_int (r.cdfid, r.seg_start_id, start, count, seg_start));
+		count[0] = r.n_pt;
+		check_nc_status (nc_get_vara_short (r.cdfid, r.pt_dx_id, start, count, pt_dx));
+		check_nc_status (nc_get_vara_short (r.cdfid, r.pt_dy_id, start, count, pt_dy));
+		check_nc_status (nc_close (r.cdfid));
+		
+		for (i = 0; i < n_seg; i++) {
+			seg_info[i] = (unsigned short)seg_n[i];
+			seg_area[i] = seg_level[i];
+		}
+		GMT_free ((void *)seg_n);
+		GMT_free ((void *)seg_level);
+	}
+	GMT_shore_unlock ();
+	
+	/* Points are rewritten segment by segment, so count only those in use */
+	
+	for (i = h.n_pt = 0; i < n_seg; i++) h.n_pt += (kind == 'c') ? (seg_info[i] >> 9) : seg_info[i];
+	
+	fwrite ((void *)&h, sizeof (struct GMT_SHORE_FILE_HEADER), (size_t)1, fp);
+	
+	for (i = 0; i < n_bin; i++) {
+		bin.info = (bin_info) ? bin_info[i] : 0;
+		bin.nseg = bin_nseg[i];
+		bin.firstseg = bin_firstseg[i];
+		fwrite ((void *)&bin, sizeof (struct GMT_SHORE_FILE_BIN), (size_t)1, fp);
+	}
+	
+	for (i = seg.start = 0; i < n_seg; i++) {
+		seg.info = seg_info[i];
+		seg.area = seg_area[i];
+		fwrite ((void *)&seg, sizeof (struct GMT_SHORE_FILE_SEG), (size_t)1, fp);
+		seg.start += (kind == 'c') ? (seg_info[i] >> 9) : seg_info[i];
+	}
+	
+	for (i = 0; i < n_seg; i++) {
+		n = (kind == 'c') ? (seg_info[i] >> 9) : seg_info[i];
+		fwrite ((void *)&pt_dx[seg_start[i]], sizeof (short), (size_t)n, fp);
+		fwrite ((void *)&pt_dy[seg_start[i]], sizeof (short), (size_t)n, fp);
+	}
+	
+	i = (ferror (fp) != 0);
+	if (fclose (fp)) i = 1;
+	
+	if (bin_info) GMT_free ((void *)bin_info);
+	GMT_free ((void *)bin_nseg);
+	GMT_free ((void *)bin_firstseg);
+	GMT_free ((void *)seg_info);
+	GMT_free ((void *)seg_area);
+	GMT_free ((void *)seg_start);
+	GMT_free ((void *)pt_dx);
+	GMT_free ((void *)pt_dy);
+	
+	if (i) {
+		fprintf (stderr, "%s: Error writing %s\n", GMT_program, file);
+		return (-1);
+	}
+	return (0);
+}
+
+int GMT_shore_index (char kind, char res, char *file)
+{
+	/* Writes the bin index of the netcdf database of the given kind (c, b, r) and
+	 * resolution to file.  Installed as binned_*.idx next to the netcdf file it lets
+	 * GMT_init_shore and GMT_init_br skip empty bins and know each bin's size */
+	 
+	int i, n_bin, n_seg, n_pt, n_used, top_level, *seg_n, *seg_level, *seg_info, *bin_firstseg, *bin_npt;
+	short *bin_nseg, *seg_s;
+	unsigned char *bin_used;
+	char name[32], path[BUFSIZ];
+	size_t start[1], count[1];
+	FILE *fp;
+	struct GMT_SHORE c;
+	struct GMT_BR r;
+	struct GMT_SHORE_INDEX_HEADER h;
+	
+	GMT_shore_file_name (kind, res, "cdf", name);
+	if (!GMT_getpathname (name, path)) {
+		fprintf (stderr, "%s: Cannot find %s\n", GMT_program, name);
+		return (-1);
+	}
+	if ((fp = fopen (file, "wb")) == NULL) {
+		fprintf (stderr, "%s: Cannot create %s\n", GMT_program, file);
+		return (-1);
+	}
+	
+	start[0] = 0;
+	GMT_shore_lock ();	/* The netcdf library is not reentrant */
+	if (kind == 'c') {
+		GMT_shore_read_header (&c, path);
+		n_bin = c.n_bin;	n_seg = c.n_seg;	n_pt = c.n_pt;
+		bin_nseg = c.bin_nseg;	bin_firstseg = c.bin_firstseg;
+		GMT_free ((void *)c.bin_info);
+		
+		seg_info = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index");
+		seg_n = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index");
+		seg_level = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index");
+		count[0] = n_seg;
+		check_nc_status (nc_get_vara_int (c.cdfid, c.seg_info_id, start, count, seg_info));
+		check_nc_status (nc_close (c.cdfid));
+		for (i = 0; i < n_seg; i++) {
+			seg_n[i] = seg_info[i] >> 9;
+			seg_level[i] = (seg_info[i] >> 6) & 7;
+		}
+		GMT_free ((void *)seg_info);
+	}
+	else {
+		GMT_br_read_header (&r, path);
+		n_bin = r.n_bin;	n_seg = r.n_seg;	n_pt = r.n_pt;
+		bin_nseg = r.bin_nseg;	bin_firstseg = r.bin_firstseg;
+		
+		seg_s = (short *) GMT_memory (VNULL, (size_t)n_seg, sizeof (short), "GMT_shore_index");
+		seg_n = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index");
+		seg_level = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index");
+		count[0] = n_seg;
+		check_nc_status (nc_get_vara_short (r.cdfid, r.seg_n_id, start, count, seg_s));
+		for (i = 0; i < n_seg; i++) seg_n[i] = (unsigned short)seg_s[i];
+		check_nc_status (nc_get_vara_short (r.cdfid, r.seg_level_id, start, count, seg_s));
+		for (i = 0; i < n_seg; i++) seg_level[i] = seg_s[i];
+		check_nc_status (nc_close (r.cdfid));
+		GMT_free ((void *)seg_s);
+	}
+	GMT_shore_unlock ();
+	
+	n_used = GMT_shore_tally (n_bin, bin_nseg, bin_firstseg, seg_n, seg_level, &bin_npt, &bin_used, &top_level);
+	
+	memset ((void *)&h, 0, sizeof (struct GMT_SHORE_INDEX_HEADER));
+	memcpy ((void *)h.magic, (void *)GMT_SHORE_INDEX_MAGIC, (size_t)8);
+	h.version = GMT_SHORE_INDEX_VERSION;
+	h.byte_order = GMT_SHORE_BYTE_ORDER;
+	h.kind = kind;
+	h.n_bin = n_bin;	h.n_seg = n_seg;	h.n_pt = n_pt;
+	h.n_used = n_used;
+	h.top_level = top_level;
+	
+	fwrite ((void *)&h, sizeof (struct GMT_SHORE_INDEX_HEADER), (size_t)1, fp);
+	fwrite ((void *)bin_npt, sizeof (int), (size_t)n_bin, fp);
+	fwrite ((void *)bin_nseg, sizeof (short), (size_t)n_bin, fp);
+	fwrite ((void *)bin_used, (size_t)1, (size_t)((n_bin + 7) / 8), fp);
+	
+	i = (ferror (fp) != 0);
+	if (fclose (fp)) i = 1;
+	
+	GMT_free ((void *)bin_nseg);
+	GMT_free ((void *)bin_firstseg);
+	GMT_free ((void *)seg_n);
+	GMT_free ((void *)seg_level);
+	GMT_free ((void *)bin_npt);
+	GMT_free ((void *)bin_used);
+	
+	if (i) {
+		fprintf (stderr, "%s: Error writing %s\n", GMT_program, file);
+		return (-1);
+	}
+	return (0);
+}
+
+int GMT_shore_rank (char kind, char res, char *file)
+{
+	/* Writes the point ranks of the netcdf database of the given kind (c, b, r) and
+	 * resolution to file.  Installed as binned_*.rnk next to the database they let
+	 * GMT_get_shore_bin and GMT_get_br_bin skip the points that do not show at the
+	 * reader's tolerance.  Points are ranked by their Visvalingam effective area */
+	 
+	int i, n_seg, n_pt, n_rank, n_max, *seg_n, *seg_start, *seg_info, *rank_start, *work;
+	short *seg_s, *pt_dx, *pt_dy;
+	unsigned char *rank;
+	double *area;
+	char name[32], path[BUFSIZ];
+	size_t start[1], count[1];
+	FILE *fp;
+	struct GMT_SHORE c;
+	struct GMT_BR r;
+	struct GMT_SHORE_RANK_HEADER h;
+	
+	GMT_shore_file_name (kind, res, "cdf", name);
+	if (!GMT_getpathname (name, path)) {
+		fprintf (stderr, "%s: Cannot find %s\n", GMT_program, name);
+		return (-1);
+	}
+	if ((fp = fopen (file, "wb")) == NULL) {
+		fprintf (stderr, "%s: Cannot create %s\n", GMT_program, file);
+		return (-1);
+	}
+	
+	memset ((void *)&h, 0, sizeof (struct GMT_SHORE_RANK_HEADER));
+	memcpy ((void *)h.magic, (void *)GMT_SHORE_RANK_MAGIC, (size_t)8);
+	h.version = GMT_SHORE_RANK_VERSION;
+	h.byte_order = GMT_SHORE_BYTE_ORDER;
+	h.kind = kind;
+	start[0] = 0;
+	
+	GMT_shore_lock ();	/* The netcdf library is not reentrant */
+	if (kind == 'c') {
+		GMT_shore_read_header (&c, path);
+		h.n_bin = c.n_bin;	n_seg = h.n_seg = c.n_seg;	n_pt = h.n_pt = c.n_pt;
+		GMT_free ((void *)c.bin_info);
+		GMT_free ((void *)c.bin_nseg);
+		GMT_free ((void *)c.bin_firstseg);
+		
+		seg_info = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_rank");
+		seg_n = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_rank");
+		seg_start = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_rank");
+		pt_dx = (short *) GMT_memory (VNULL, (size_t)n_pt, sizeof (short), "GMT_shore_rank");
+		pt_dy = (short *) GMT_memory (VNULL, (size_t)n_pt, sizeof (short), "GMT_shore_rank");
+		
+		count[0] = n_seg;
+		check_nc_status (nc_get_vara_int (c.cdfid, c.seg_info_id, start, count, seg_info));
+		check_nc_status (nc_get_vara_int (c.cdfid, c.seg_start_id, start, count, seg_start));
+		count[0] = n_pt;
+		check_nc_status (nc_get_vara_short (c.cdfid, c.pt_dx_id, start, count, pt_dx));
+		check_nc_status (nc_get_vara_short (c.cdfid, c.pt_dy_id, start, count, pt_dy));
+		check_nc_status (nc_close (c.cdfid));
+		for (i = 0; i < n_seg; i++) seg_n[i] = seg_info[i] >> 9;
+		GMT_free ((void *)seg_info);
+	}
+	else {
+		GMT_br_read_header (&r, path);
+		h.n_bin = r.n_bin;	n_seg = h.n_seg = r.n_seg;	n_pt = h.n_pt = r.n_pt;
+		GMT_free ((void *)r.bin_nseg);
+		GMT_free ((void *)r.bin_firstseg);
+		
+		seg_s = (short *) GMT_memory (VNULL, (size_t)n_seg, sizeof (short), "GMT_shore_rank");
+		seg_n = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_rank");
+		seg_start = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_rank");
+		pt_dx = (short *) GMT_memory (VNULL, (size_t)n_pt, sizeof (short), "GMT_shore_rank");
+		pt_dy = (short *) GMT_memory (VNULL, (size_t)n_pt, sizeof (short), "GMT_shore_rank");
+		
+		count[0] = n_seg;
+		check_nc_status (nc_get_vara_short (r.cdfid, r.seg_n_id, start, count, seg_s));
+		check_nc_status (nc_get_vara_int (r.cdfid, r.seg_start_id, start, count, seg_start));
+		count[0] = n_pt;
+		check_nc_status (nc_get_vara_short (r.cdfid, r.pt_dx_id, start, count, pt_dx));
+		check_nc_status (nc_get_vara_short (r.cdfid, r.pt_dy_id, start, count, pt_dy));
+		check_nc_status (nc_close (r.cdfid));
+		for (i = 0; i < n_seg; i++) seg_n[i] = (unsigned short)seg_s[i];
+		GMT_free ((void *)seg_s);
+	}
+	GMT_shore_unlock ();
+	
+	/* Ranks are stored segment by segment, in the order of the compact database */
+	
+	rank_start = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_rank");
+	for (i = n_rank = n_max = 0; i < n_seg; i++) {
+		rank_start[i] = n_rank;
+		n_rank += seg_n[i];
+		if (seg_n[i] > n_max) n_max = seg_n[i];
+	}
+	h.n_rank = n_rank;
+	
+	rank = (unsigned char *) GMT_memory (VNULL, (size_t)n_rank, (size_t)1, "GMT_shore_rank");
+	work = (int *) GMT_memory (VNULL, (size_t)(4 * n_max), sizeof (int), "GMT_shore_rank");
+	area = (double *) GMT_memory (VNULL, (size_t)n_max, sizeof (double), "GMT_shore_rank");
+	
+	for (i = 0; i < n_seg; i++) GMT_shore_rank_segment (&pt_dx[seg_start[i]], &pt_dy[seg_start[i]], seg_n[i], &rank[rank_start[i]], work, area);
 	
+	fwrite ((void *)&h, sizeof (struct GMT_SHORE_RANK_HEADER), (size_t)1, fp);
+	fwrite ((void *)rank_start, sizeof (int), (size_t)n_seg, fp);
+	fwrite ((void *)rank, (size_t)1, (size_t)n_rank, fp);
+	
+	i = (ferror (fp) != 0);
+	if (fclose (fp)) i = 1;
+	
+	GMT_free ((void *)seg_n);
+	GMT_free ((void *)seg_start);
+	GMT_free ((void *)pt_dx);
+	GMT_free ((void *)pt_dy);
+	GMT_free ((void *)rank_start);
+	GMT_free ((void *)rank);
+	GMT_free ((void *)work);
+	GMT_free ((void *)area);
+	
+	if (i) {
+		fprintf (stderr, "%s: Error writing %s\n", GMT_program, file);
+		return (-1);
+	}
+	return (0);
 }
 
+int GMT_shore_min_rank (unsigned char *rank, double scale, double tolerance)
+{
+	/* Returns the lowest rank of the points that are kept at tolerance (in degrees)
+	 * in a database whose dx, dy are scale degrees, or 0 if all points are kept.
+	 * A point is dropped if its triangle is smaller than one with base and height tolerance */
+	 
+	double d;
+	
+	if (rank == NULL || tolerance <= 0.0) return (0);
+	d = tolerance / scale;
+	return (GMT_shore_rank_of (0.5 * d * d));
+}
 
 /* ---------- LOWER LEVEL FUNCTIONS CALLED BY THE ABOVE ------------ */
 
+int GMT_shore_tally (int n_bin, short *bin_nseg, int *bin_firstseg, int *seg_n, int *seg_level, int **bin_npt, unsigned char **bin_used, int *top_level)
+{
+	/* Builds the bin index from the number of points and level of every segment.
+	 * Returns the number of bins that have segments */
+	 
+	int i, k, n_used;
+	
+	*bin_npt = (int *) GMT_memory (VNULL, (size_t)n_bin, sizeof (int), "GMT_shore_tally");
+	*bin_used = (unsigned char *) GMT_memory (VNULL, (size_t)((n_bin + 7) / 8), (size_t)1, "GMT_shore_tally");
+	
+	for (i = n_used = *top_level = 0; i < n_bin; i++) {
+		if (bin_nseg[i] == 0) continue;
+		(*bin_used)[i >> 3] |= (1 << (i & 7));
+		n_used++;
+		for (k = bin_firstseg[i]; k < bin_firstseg[i] + bin_nseg[i]; k++) {
+			(*bin_npt)[i] += seg_n[k];
+			if (seg_level[k] > *top_level) *top_level = seg_level[k];
+		}
+	}
+	return (n_used);
+}
+
+void GMT_shore_index_map (struct GMT_SHORE_DB *db)
+{
+	/* Builds the bin index of a mapped compact database from its segment table */
+	
+	int i, n_seg, *seg_n, *seg_level;
+	struct GMT_SHORE_FILE_SEG *fs;
+	
+	n_seg = (db->kind == 'c') ? db->shore.n_seg : db->br.n_seg;
+	fs = (db->kind == 'c') ? db->shore.map_seg : db->br.map_seg;
+	seg_n = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index_map");
+	seg_level = (int *) GMT_memory (VNULL, (size_t)n_seg, sizeof (int), "GMT_shore_index_map");
+	
+	for (i = 0; i < n_seg; i++) {
+		seg_n[i] = (db->kind == 'c') ? fs[i].info >> 9 : fs[i].info;
+		seg_level[i] = (db->kind == 'c') ? (fs[i].info >> 6) & 7 : fs[i].area;
+	}
+	
+	if (db->kind == 'c')
+		GMT_shore_tally (db->shore.n_bin, db->shore.bin_nseg, db->shore.bin_firstseg, seg_n, seg_level, &db->shore.bin_npt, &db->shore.bin_used, &db->shore.top_level);
+	else
+		GMT_shore_tally (db->br.n_bin, db->br.bin_nseg, db->br.bin_firstseg, seg_n, seg_level, &db->br.bin_npt, &db->br.bin_used, &db->br.top_level);
+	
+	GMT_free ((void *)seg_n);
+	GMT_free ((void *)seg_level);
+}
+
+int GMT_shore_read_index (struct GMT_SHORE_DB *db, char *path)
+{
+	/* Loads the bin index written by GMT_shore_index for the netcdf database in db.
+	 * An index that does not match the database is ignored with a warning */
+	 
+	int i, n_bin, n_seg, n_pt, *npt;
+	char *map;
+	size_t size;
+	short *nseg, *bin_nseg;
+	struct GMT_SHORE_INDEX_HEADER *h;
+	
+	if ((map = GMT_shore_map (path, &size)) == NULL) return (-1);
+	
+	if (db->kind == 'c') {
+		n_bin = db->shore.n_bin;	n_seg = db->shore.n_seg;	n_pt = db->shore.n_pt;	bin_nseg = db->shore.bin_nseg;
+	}
+	else {
+		n_bin = db->br.n_bin;	n_seg = db->br.n_seg;	n_pt = db->br.n_pt;	bin_nseg = db->br.bin_nseg;
+	}
+	
+	h = (struct GMT_SHORE_INDEX_HEADER *)map;
+	i = (size == sizeof (struct GMT_SHORE_INDEX_HEADER) + n_bin * (sizeof (int) + sizeof (short)) + (n_bin + 7) / 8);
+	if (i) i = (!strncmp (h->magic, GMT_SHORE_INDEX_MAGIC, (size_t)8) && h->version == GMT_SHORE_INDEX_VERSION && h->byte_order == GMT_SHORE_BYTE_ORDER);
+	if (i) i = (h->kind == db->kind && h->n_bin == n_bin && h->n_seg == n_seg && h->n_pt == n_pt);
+	npt = (int *)(map + sizeof (struct GMT_SHORE_INDEX_HEADER));
+	nseg = (short *)(&npt[n_bin]);
+	if (i) i = !memcmp ((void *)nseg, (void *)bin_nseg, n_bin * sizeof (short));
+	if (!i) {
+		fprintf (stderr, "%s: Warning: %s does not match its database and is ignored\n", GMT_program, path);
+		GMT_shore_unmap (map, size);
+		return (-1);
+	}
+	
+	if (db->kind == 'c') {
+		db->shore.bin_npt = (int *) GMT_memory (VNULL, (size_t)n_bin, sizeof (int), "GMT_shore_read_index");
+		db->shore.bin_used = (unsigned char *) GMT_memory (VNULL, (size_t)((n_bin + 7) / 8), (size_t)1, "GMT_shore_read_index");
+		memcpy ((void *)db->shore.bin_npt, (void *)npt, n_bin * sizeof (int));
+		memcpy ((void *)db->shore.bin_used, (void *)&nseg[n_bin], (size_t)((n_bin + 7) / 8));
+		db->shore.top_level = h->top_level;
+	}
+	else {
+		db->br.bin_npt = (int *) GMT_memory (VNULL, (size_t)n_bin, sizeof (int), "GMT_shore_read_index");
+		db->br.bin_used = (unsigned char *) GMT_memory (VNULL, (size_t)((n_bin + 7) / 8), (size_t)1, "GMT_shore_read_index");
+		memcpy ((void *)db->br.bin_npt, (void *)npt, n_bin * sizeof (int));
+		memcpy ((void *)db->br.bin_used, (void *)&nseg[n_bin], (size_t)((n_bin + 7) / 8));
+		db->br.top_level = h->top_level;
+	}
+	
+	GMT_shore_unmap (map, size);
+	return (0);
+}
+
+int GMT_shore_read_rank (struct GMT_SHORE_DB *db, char *path)
+{
+	/* Maps the point ranks written by GMT_shore_rank for the database in db.
+	 * Ranks that do not match the database are ignored with a warning */
+	 
+	int i, n_bin, n_seg, n_pt;
+	char *map;
+	size_t size;
+	struct GMT_SHORE_RANK_HEADER *h;
+	
+	if ((map = GMT_shore_map (path, &size)) == NULL) return (-1);
+	
+	if (db->kind == 'c') {
+		n_bin = db->shore.n_bin;	n_seg = db->shore.n_seg;	n_pt = db->shore.n_pt;
+	}
+	else {
+		n_bin = db->br.n_bin;	n_seg = db->br.n_seg;	n_pt = db->br.n_pt;
+	}
+	
+	/* A compact database only counts the points in use, which are the ones ranked */
+	
+	h = (struct GMT_SHORE_RANK_HEADER *)map;
+	i = (size >= sizeof (struct GMT_SHORE_RANK_HEADER));
+	if (i) i = (!strncmp (h->magic, GMT_SHORE_RANK_MAGIC, (size_t)8) && h->version == GMT_SHORE_RANK_VERSION && h->byte_order == GMT_SHORE_BYTE_ORDER);
+	if (i) i = (h->kind == db->kind && h->n_bin == n_bin && h->n_seg == n_seg && (h->n_pt == n_pt || h->n_rank == n_pt));
+	if (i) i = (size == sizeof (struct GMT_SHORE_RANK_HEADER) + n_seg * sizeof (int) + h->n_rank);
+	if (!i) {
+		fprintf (stderr, "%s: Warning: %s does not match its database and is ignored\n", GMT_program, path);
+		GMT_shore_unmap (map, size);
+		return (-1);
+	}
+	
+	if (db->kind == 'c') {
+		db->shore.rank_map = map;
+		db->shore.rank_map_size = size;
+		db->shore.rank_start = (int *)(map + sizeof (struct GMT_SHORE_RANK_HEADER));
+		db->shore.rank = (unsigned char *)(&db->shore.rank_start[n_seg]);
+	}
+	else {
+		db->br.rank_map = map;
+		db->br.rank_map_size = size;
+		db->br.rank_start = (int *)(map + sizeof (struct GMT_SHORE_RANK_HEADER));
+		db->br.rank = (unsigned char *)(&db->br.rank_start[n_seg]);
+	}
+	return (0);
+}
+
+int GMT_shore_rank_of (double area)
+{
+	/* Returns the rank of an effective area in squared dx/dy units: four steps
+	 * per doubling of the area, 0 below one unit and at most 254 */
+	 
+	int r;
+	
+	if (area < 1.0) return (0);
+	r = 1 + (int)floor (4.0 * log (area) / log (2.0));
+	return (MIN (r, GMT_SHORE_RANK_KEEP - 1));
+}
+
+double GMT_shore_rank_area (short *dx, short *dy, int p, int i, int q)
+{	/* Area of the triangle that point i makes with its neighbours p and q */
+	double x0, y0;
+	
+	x0 = (unsigned short)dx[i];
+	y0 = (unsigned short)dy[i];
+	return (0.5 * fabs (((unsigned short)dx[p] - x0) * ((unsigned short)dy[q] - y0) - ((unsigned short)dx[q] - x0) * ((unsigned short)dy[p] - y0)));
+}
+
+void GMT_shore_rank_segment (short *dx, short *dy, int n, unsigned char *rank, int *work, double *area)
+{
+	/* Ranks the n points of a segment by repeatedly dropping the interior point whose
+	 * triangle with its remaining neighbours is smallest (Visvalingam).  A point's effective
+	 * area is the largest dropped so far, so the ranks never decrease in the dropping order.
+	 * The ends are always kept, and so are the last two interior points of a closed segment.
+	 * work must hold 4 * n ints and area n doubles */
+	 
+	int i, p, q, nh, *prev, *next, *heap, *pos;
+	BOOLEAN closed;
+	double max_area;
+	
+	if (n <= 0) return;
+	prev = work;	next = &work[n];	heap = &work[2*n];	pos = &work[3*n];
+	closed = (n > 3 && dx[0] == dx[n-1] && dy[0] == dy[n-1]);
+	rank[0] = rank[n-1] = GMT_SHORE_RANK_KEEP;
+	
+	for (i = 1, nh = 0; i < n - 1; i++) {
+		prev[i] = i - 1;
+		next[i] = i + 1;
+		area[i] = GMT_shore_rank_area (dx, dy, i - 1, i, i + 1);
+		heap[nh] = i;
+		pos[i] = nh++;
+		GMT_shore_heap_fix (heap, pos, area, nh, nh - 1);
+	}
+	if (n > 1) next[0] = 1;
+	prev[n-1] = n - 2;
+	
+	for (max_area = 0.0; nh > 0; ) {
+		i = heap[0];	/* Smallest triangle left */
+		if (--nh > 0) {
+			heap[0] = heap[nh];
+			pos[heap[0]] = 0;
+			GMT_shore_heap_fix (heap, pos, area, nh, 0);
+		}
+		if (area[i] > max_area) max_area = area[i];
+		rank[i] = (closed && nh < 2) ? GMT_SHORE_RANK_KEEP : GMT_shore_rank_of (max_area);
+		
+		p = prev[i];	q = next[i];
+		next[p] = q;	prev[q] = p;
+		if (p > 0) {
+			area[p] = GMT_shore_rank_area (dx, dy, prev[p], p, q);
+			GMT_shore_heap_fix (heap, pos, area, nh, pos[p]);
+		}
+		if (q < n - 1) {
+			area[q] = GMT_shore_rank_area (dx, dy, p, q, next[q]);
+			GMT_shore_heap_fix (heap, pos, area, nh, pos[q]);
+		}
+	}
+}
+
+void GMT_shore_heap_fix (int *heap, int *pos, double *area, int nh, int k)
+{
+	/* Moves entry k of the min-heap of nh point ids up or down to where its area belongs */
+	
+	int j, t;
+	
+	while (k > 0 && area[heap[k]] < area[heap[(k-1)/2]]) {
+		j = (k - 1) / 2;
+		t = heap[j];	heap[j] = heap[k];	heap[k] = t;
+		pos[heap[j]] = j;	pos[heap[k]] = k;
+		k = j;
+	}
+	while ((j = 2 * k + 1) < nh) {
+		if (j + 1 < nh && area[heap[j+1]] < area[heap[j]]) j++;
+		if (area[heap[j]] >= area[heap[k]]) break;
+		t = heap[j];	heap[j] = heap[k];	heap[k] = t;
+		pos[heap[j]] = j;	pos[heap[k]] = k;
+		k = j;
+	}
+}
+
+int GMT_shore_thin_copy (short *dx, short *dy, int n, unsigned char *rank, int min_rank, short *out)
+{
+	/* Copies the dx and then the dy of the points ranked min_rank or more to out.
+	 * Returns how many points were copied */
+	 
+	int j, k;
+	
+	for (j = k = 0; j < n; j++) if (rank[j] >= min_rank) out[k++] = dx[j];
+	for (j = 0; j < n; j++) if (rank[j] >= min_rank) out[k++] = dy[j];
+	return (k / 2);
+}
+
+short *GMT_shore_thin (struct GMT_SHORE_SEGMENT *seg, int ns, int *offset, unsigned char *rank, int min_rank, int *n_pt)
+{
+	/* Copies the points of the ns segments that are ranked min_rank or more to a new arena and
+	 * points the segments at them.  offset has the rank offset of each segment.  The points
+	 * dropped are only looked at through their ranks.  Returns the arena; n_pt is set to its size */
+	 
+	int s, j, n;
+	short *arena;
+	
+	for (s = n = 0; s < ns; s++) for (j = 0; j < seg[s].n; j++) if (rank[offset[s] + j] >= min_rank) n++;
+	arena = (short *) GMT_memory (VNULL, (size_t)(2 * n), sizeof (short), "GMT_shore_thin");
+	
+	for (s = n = 0; s < ns; s++) {
+		seg[s].n = GMT_shore_thin_copy (seg[s].dx, seg[s].dy, seg[s].n, &rank[offset[s]], min_rank, &arena[2*n]);
+		seg[s].dx = &arena[2*n];
+		seg[s].dy = &arena[2*n + seg[s].n];
+		n += seg[s].n;
+	}
+	*n_pt = n;
+	return (arena);
+}
+
+short *GMT_br_thin (struct GMT_BR_SEGMENT *seg, int ns, int *offset, unsigned char *rank, int min_rank, int *n_pt)
+{
+	/* As GMT_shore_thin, for border and river segments */
+	
+	int s, j, n;
+	short *arena;
+	
+	for (s = n = 0; s < ns; s++) for (j = 0; j < seg[s].n; j++) if (rank[offset[s] + j] >= min_rank) n++;
+	arena = (short *) GMT_memory (VNULL, (size_t)(2 * n), sizeof (short), "GMT_br_thin");
+	
+	for (s = n = 0; s < ns; s++) {
+		seg[s].n = GMT_shore_thin_copy (seg[s].dx, seg[s].dy, seg[s].n, &rank[offset[s]], min_rank, &arena[2*n]);
+		seg[s].dx = &arena[2*n];
+		seg[s].dy = &arena[2*n + seg[s].n];
+		n += seg[s].n;
+	}
+	*n_pt = n;
+	return (arena);
+}
+
+void GMT_shore_read_bin (int b, struct GMT_SHORE *c, int cut_area, int min_level, int max_level)
+{
+	/* Sets c->seg from the bin cache or the database.  Caller must hold the shore lock */
+	
+	size_t start[1], count[1], bytes;
+	BOOLEAN cached = !(c->db && c->db->flushed);	/* Readers of a flushed database keep out of the cache */
+	int *seg_area, *seg_info, *seg_start, *offset, filter[3];
+	int s, i, first, last, min_rank, n_pt;
+	short *arena;
+	
+	min_rank = GMT_shore_min_rank (c->rank, c->scale, c->tolerance);
+	filter[0] = cut_area;
+	filter[1] = min_level + (min_rank << 8);	/* Bins thinned differently are cached apart */
+	filter[2] = max_level;
+	
+	if (cached && (c->cache = GMT_bin_cache_find ('c', c->res, c->bins[b], filter))) {	/* Already decoded */
+		c->ns = c->cache->ns;
+		c->seg = (struct GMT_SHORE_SEGMENT *)c->cache->seg;
+		if (c->ns == 0) {	/* Nothing to hold on to */
+			GMT_bin_cache_release (c->cache);
+			c->cache = NULL;
+		}
+		return;
+	}
+	
+	/* With ranks only the points that show at the tolerance are kept */
+	
+	offset = (min_rank) ? (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin") : (int *)NULL;
+	
+	if (c->map) {	/* Compact database: segments point straight into the mapping unless thinned */
+		c->ns = GMT_shore_map_segments (c, b, cut_area, min_level, max_level, offset);
+		bytes = sizeof (struct GMT_BIN_CACHE) + c->ns * sizeof (struct GMT_SHORE_SEGMENT);
+		if (offset) {
+			if (c->ns) {
+				c->arena = GMT_shore_thin (c->seg, c->ns, offset, c->rank, min_rank, &n_pt);
+				bytes += 2 * n_pt * sizeof (short);
+			}
+			GMT_free ((void *)offset);
+		}
+		if (cached && (c->cache = GMT_bin_cache_add ('c', c->res, c->bins[b], filter, c->ns, (void *)c->seg, c->arena, bytes))) {
+			if (c->ns == 0) {
+				GMT_bin_cache_release (c->cache);
+				c->cache = NULL;
+			}
+		}
+		return;
+	}
+	
+	start[0] = c->bin_firstseg[b];
+	count[0] = c->bin_nseg[b];
+	
+	seg_area = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin");
+	seg_info = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin");
+	seg_start = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_shore_bin");
+	
+	check_nc_status (nc_get_vara_int (c->cdfid, c->seg_area_id, start, count, seg_area));
+        check_nc_status (nc_get_vara_int (c->cdfid, c->seg_info_id, start, count, seg_info));
+        check_nc_status (nc_get_vara_int (c->cdfid, c->seg_start_id, start, count, seg_start));
+	
+	/* First tally how many useful segments */
+	
+	for (s = i = 0; i < c->bin_nseg[b]; i++) {
+		if (cut_area > 0 && seg_area[i] < cut_area) continue;
+		if (((seg_info[i] >> 6) & 7) < min_level) continue;
+		if (((seg_info[i] >> 6) & 7) > max_level) continue;
+		seg_area[s] = seg_area[i];
+		seg_info[s] = seg_info[i];
+		seg_start[s] = seg_start[i];
+		if (offset) offset[s] = c->rank_start[c->bin_firstseg[b] + i];
+		s++;
+	}
+	c->ns = s;
+	
+	if (c->ns == 0) {	/* No useful segments in this bin; remember that too */
+		GMT_free ((void *) seg_info);	
+		GMT_free ((void *) seg_area);	
+		GMT_free ((void *) seg_start);
+		if (offset) GMT_free ((void *)offset);
+		if (cached && (c->cache = GMT_bin_cache_add ('c', c->res, c->bins[b], filter, 0, VNULL, (short *)NULL, sizeof (struct GMT_BIN_CACHE)))) {
+			GMT_bin_cache_release (c->cache);
+			c->cache = NULL;
+		}
+		return;
+	}
+	
+	c->seg = (struct GMT_SHORE_SEGMENT *) GMT_memory (VNULL, (size_t)c->ns, sizeof (struct GMT_SHORE_SEGMENT), "GMT_get_shore_bin");
+	
+	/* The segments of a bin are stored next to each other, so read the whole point
+	 * range they span with one call per variable into a single arena */
+	
+	for (s = 0, first = seg_start[0], last = 0; s < c->ns; s++) {
+		c->seg[s].level = (seg_info[s] >> 6) & 7;
+		c->seg[s].n = (seg_info[s] >> 9);
+		c->seg[s].entry = (seg_info[s] >> 3) & 7;
+		c->seg[s].exit = seg_info[s] & 7;
+		if (seg_start[s] < first) first = seg_start[s];
+		if (seg_start[s] + c->seg[s].n > last) last = seg_start[s] + c->seg[s].n;
+	}
+	
+	c->arena = (short *) GMT_memory (VNULL, (size_t)(2 * (last - first)), sizeof (short), "GMT_get_shore_bin");
+	start[0] = first;
+	count[0] = last - first;
+	check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dx_id, start, count, c->arena));
+        check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dy_id, start, count, &c->arena[last - first]));
+	
+	for (s = 0; s < c->ns; s++) {
+		c->seg[s].dx = &c->arena[seg_start[s] - first];
+		c->seg[s].dy = &c->arena[last - first + seg_start[s] - first];
+	}
+	bytes = sizeof (struct GMT_BIN_CACHE) + c->ns * sizeof (struct GMT_SHORE_SEGMENT) + 2 * (last - first) * sizeof (short);
+	
+	if (offset) {	/* Repack the points that matter into a smaller arena */
+		arena = c->arena;
+		c->arena = GMT_shore_thin (c->seg, c->ns, offset, c->rank, min_rank, &n_pt);
+		bytes = sizeof (struct GMT_BIN_CACHE) + c->ns * sizeof (struct GMT_SHORE_SEGMENT) + 2 * n_pt * sizeof (short);
+		GMT_free ((void *)arena);
+		GMT_free ((void *)offset);
+	}
+		
+	GMT_free ((void *) seg_info);	
+	GMT_free ((void *) seg_area);	
+	GMT_free ((void *) seg_start);	
+	
+	if (cached) c->cache = GMT_bin_cache_add ('c', c->res, c->bins[b], filter, c->ns, (void *)c->seg, c->arena, bytes);
+}
+
+void GMT_br_read_bin (int b, struct GMT_BR *c, int *level, int n_levels)
+{
+	/* Sets c->seg from the bin cache or the database.  Caller must hold the shore lock */
+	
+	size_t start[1], count[1], bytes;
+	BOOLEAN cached = !(c->db && c->db->flushed);	/* Readers of a flushed database keep out of the cache */
+	int *seg_start, *offset, filter[3];
+	short *seg_n, *seg_level, *arena;
+	int s, i, k, skip, first, last, min_rank, n_pt;
+	
+	/* The level selection is kept as a bit mask; -1 means all levels */
+	
+	for (k = 0, filter[0] = (n_levels == 0) ? -1 : 0; k < n_levels; k++) if (level[k] >= 0 && level[k] < 31) filter[0] |= (1 << level[k]);
+	min_rank = GMT_shore_min_rank (c->rank, c->scale, c->tolerance);
+	filter[1] = min_rank << 8;
+	filter[2] = 0;
+	
+	if (cached && (c->cache = GMT_bin_cache_find (c->which, c->res, c->bins[b], filter))) {	/* Already decoded */
+		c->ns = c->cache->ns;
+		c->seg = (struct GMT_BR_SEGMENT *)c->cache->seg;
+		if (c->ns == 0) {	/* Nothing to hold on to */
+			GMT_bin_cache_release (c->cache);
+			c->cache = NULL;
+		}
+		return;
+	}
+	
+	offset = (min_rank) ? (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_br_bin") : (int *)NULL;
+	
+	if (c->map) {	/* Compact database: segments point straight into the mapping unless thinned */
+		c->ns = GMT_br_map_segments (c, b, level, n_levels, offset);
+		bytes = sizeof (struct GMT_BIN_CACHE) + c->ns * sizeof (struct GMT_BR_SEGMENT);
+		if (offset) {
+			if (c->ns) {
+				c->arena = GMT_br_thin (c->seg, c->ns, offset, c->rank, min_rank, &n_pt);
+				bytes += 2 * n_pt * sizeof (short);
+			}
+			GMT_free ((void *)offset);
+		}
+		if (cached && (c->cache = GMT_bin_cache_add (c->which, c->res, c->bins[b], filter, c->ns, (void *)c->seg, c->arena, bytes))) {
+			if (c->ns == 0) {
+				GMT_bin_cache_release (c->cache);
+				c->cache = NULL;
+			}
+		}
+		return;
+	}
+	
+	start[0] = c->bin_firstseg[b];
+	count[0] = c->bin_nseg[b];
+	
+	seg_n = (short *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (short), "GMT_get_br_bin");
+	seg_level = (short *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (short), "GMT_get_br_bin");
+	seg_start = (int *) GMT_memory (VNULL, (size_t)c->bin_nseg[b], sizeof (int), "GMT_get_br_bin");
+	
+	check_nc_status (nc_get_vara_short (c->cdfid, c->seg_n_id, start, count, seg_n));
+        check_nc_status (nc_get_vara_short (c->cdfid, c->seg_level_id, start, count, seg_level));
+        check_nc_status (nc_get_vara_int (c->cdfid, c->seg_start_id, start, count, seg_start));
+
+
+	/* First tally how many useful segments */
+	
+	for (s = i = 0; i < c->ns; i++) {
+		if (n_levels == 0)
+			skip = FALSE;
+		else {
+			for (k = 0, skip = TRUE; skip && k < n_levels; k++)
+				if (seg_level[i] == level[k]) skip = FALSE;
+		}
+		if (skip) continue;
+		seg_n[s] = seg_n[i];
+		seg_level[s] = seg_level[i];
+		seg_start[s] = seg_start[i];
+		if (offset) offset[s] = c->rank_start[c->bin_firstseg[b] + i];
+		s++;
+	}
+	c->ns = s;
+	
+	if (c->ns == 0) {	/* No useful segments in this bin; remember that too */
+		GMT_free ((void *) seg_n);	
+		GMT_free ((void *) seg_level);	
+		GMT_free ((void *) seg_start);	
+		if (offset) GMT_free ((void *)offset);
+		if (cached && (c->cache = GMT_bin_cache_add (c->which, c->res, c->bins[b], filter, 0, VNULL, (short *)NULL, sizeof (struct GMT_BIN_CACHE)))) {
+			GMT_bin_cache_release (c->cache);
+			c->cache = NULL;
+		}
+		return;
+	}
+
+	c->seg = (struct GMT_BR_SEGMENT *) GMT_memory (VNULL, (size_t)c->ns, sizeof (struct GMT_BR_SEGMENT), "GMT_get_br_bin");
+	
+	/* Read the point range spanned by the segments with one call per variable */
+	
+	for (s = 0, first = seg_start[0], last = 0; s < c->ns; s++) {
+		c->seg[s].n = seg_n[s];
+		c->seg[s].level = seg_level[s];
+		if (seg_start[s] < first) first = seg_start[s];
+		if (seg_start[s] + c->seg[s].n > last) last = seg_start[s] + c->seg[s].n;
+	}
+	
+	c->arena = (short *) GMT_memory (VNULL, (size_t)(2 * (last - first)), sizeof (short), "GMT_get_br_bin");
+	start[0] = first;
+	count[0] = last - first;
+	check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dx_id, start, count, c->arena));
+        check_nc_status (nc_get_vara_short (c->cdfid, c->pt_dy_id, start, count, &c->arena[last - first]));
+	
+	for (s = 0; s < c->ns; s++) {
+		c->seg[s].dx = &c->arena[seg_start[s] - first];
+		c->seg[s].dy = &c->arena[last - first + seg_start[s] - first];
+	}
+	bytes = sizeof (struct GMT_BIN_CACHE) + c->ns * sizeof (struct GMT_BR_SEGMENT) + 2 * (last - first) * sizeof (short);
+	
+	if (offset) {	/* Repack the points that matter into a smaller arena */
+		arena = c->arena;
+		c->arena = GMT_br_thin (c->seg, c->ns, offset, c->rank, min_rank, &n_pt);
+		bytes = sizeof (struct GMT_BIN_CACHE) + c->ns * sizeof (struct GMT_BR_SEGMENT) + 2 * n_pt * sizeof (short);
+		GMT_free ((void *)arena);
+		GMT_free ((void *)offset);
+	}
+
+	GMT_free ((void *) seg_n);	
+	GMT_free ((void *) seg_level);	
+	GMT_free ((void *) seg_start);	
+	
+	if (cached) c->cache = GMT_bin_cache_add (c->which, c->res, c->bins[b], filter, c->ns, (void *)c->seg, c->arena, bytes);
+}
+
+struct GMT_SHORE_DB *GMT_shore_get_db (char kind, char res)
+{
+	/* Returns the cached header of the requested database, opening
+	 * the file and reading its bin arrays the first time around */
+	 
+	struct GMT_SHORE_DB *db;
+	char file[32], path[BUFSIZ];
+	
+	for (db = GMT_shore_db; db; db = db->next) if (db->kind == kind && db->res == res) return (db);
+	
+	db = (struct GMT_SHORE_DB *) GMT_memory (VNULL, (size_t)1, sizeof (struct GMT_SHORE_DB), "GMT_shore_get_db");
+	db->kind = kind;
+	db->res = res;
+	
+	/* A compact binned_*.bin database takes precedence over the netcdf file */
+	
+	GMT_shore_file_name (kind, res, "bin", file);
+	if (GMT_getpathname (file, path) && GMT_shore_map_db (db, path) == 0)
+		GMT_shore_index_map (db);	/* The segment table is at hand, so no index file is needed */
+	else {
+		GMT_shore_file_name (kind, res, "cdf", file);
+		if (!GMT_getpathname (file, path)) {	/* Failed to find file */
+			GMT_free ((void *)db);
+			return (NULL);
+		}
+		if (kind == 'c')
+			GMT_shore_read_header (&db->shore, path);
+		else
+			GMT_br_read_header (&db->br, path);
+		GMT_shore_file_name (kind, res, "idx", file);
+		if (GMT_getpathname (file, path)) GMT_shore_read_index (db, path);
+	}
+	GMT_shore_file_name (kind, res, "rnk", file);
+	if (GMT_getpathname (file, path)) GMT_shore_read_rank (db, path);
+	db->shore.res = db->br.res = res;
+	db->br.which = kind;
+	db->next = GMT_shore_db;
+	GMT_shore_db = db;
+	
+	return (db);
+}
+
+void GMT_shore_read_header (struct GMT_SHORE *c, char *path)
+{
+	/* Opens a shoreline database and reads ids, attributes and all bin arrays */
+	
+	size_t start[1], count[1];
+
+	check_nc_status (nc_open (path, NC_NOWRITE,&c->cdfid));
+                
+	/* Get all id tags */
+	check_nc_status (nc_inq_varid (c->cdfid, "Bin_size_in_minutes", &c->bin_size_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_360_longitude_range", &c->bin_nx_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_180_degree_latitude_range", &c->bin_ny_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_file", &c->n_bin_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_file", &c->n_seg_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_points_in_file", &c->n_pt_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_segment_in_a_bin", &c->bin_firstseg_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Embedded_node_levels_in_a_bin", &c->bin_info_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_a_bin", &c->bin_nseg_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Embedded_npts_levels_exit_entry_for_a_segment", &c->seg_info_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Ten_times_the_km_squared_area_of_the_parent_polygon_of_a_segment", &c->seg_area_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_point_in_a_segment", &c->seg_start_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Relative_longitude_from_SW_corner_of_bin", &c->pt_dx_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Relative_latitude_from_SW_corner_of_bin", &c->pt_dy_id));
+
+	/* Get attributes */
+	check_nc_status (nc_get_att_text (c->cdfid, c->pt_dx_id, "units", c->units));
+        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "title", c->title));
+        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "source", c->source));
+
+	/* Get global variables */
+
+	start[0] = 0;
+
+	check_nc_status (nc_get_var1_int (c->cdfid, c->bin_size_id, start, &c->bin_size));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_nx_id, start, &c->bin_nx));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_ny_id, start, &c->bin_ny));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->n_bin_id, start, &c->n_bin));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->n_seg_id, start, &c->n_seg));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->n_pt_id, start, &c->n_pt));
+
+	c->scale = (c->bin_size / 60.0) / 65535.0;
+	c->bsize = c->bin_size / 60.0;
+
+	/* Get bin variables for all bins */
+
+	c->bin_info     = (short *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (short), "GMT_shore_read_header");
+	c->bin_nseg     = (short *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (short), "GMT_shore_read_header");
+	c->bin_firstseg     = (int *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (int), "GMT_shore_read_header");
+	
+	count[0] = c->n_bin;
+	check_nc_status (nc_get_vara_short (c->cdfid, c->bin_info_id, start, count, c->bin_info));
+        check_nc_status (nc_get_vara_short (c->cdfid, c->bin_nseg_id, start, count, c->bin_nseg));
+        check_nc_status (nc_get_vara_int (c->cdfid, c->bin_firstseg_id, start, count, c->bin_firstseg));
+}
+
+void GMT_br_read_header (struct GMT_BR *c, char *path)
+{
+	/* Opens a border or river database and reads ids, attributes and all bin arrays */
+	
+	size_t start[1], count[1];
+
+	check_nc_status (nc_open (path, NC_NOWRITE, &c->cdfid));
+        
+	/* Get all id tags */
+	check_nc_status (nc_inq_varid (c->cdfid, "Bin_size_in_minutes", &c->bin_size_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_360_longitude_range", &c->bin_nx_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_180_degree_latitude_range", &c->bin_ny_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_bins_in_file", &c->n_bin_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_file", &c->n_seg_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_points_in_file", &c->n_pt_id));
+         
+        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_segment_in_a_bin", &c->bin_firstseg_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "N_segments_in_a_bin", &c->bin_nseg_id));
+         
+        check_nc_status (nc_inq_varid (c->cdfid, "N_points_for_a_segment", &c->seg_n_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Hierarchial_level_of_a_segment", &c->seg_level_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Id_of_first_point_in_a_segment", &c->seg_start_id));
+ 
+        check_nc_status (nc_inq_varid (c->cdfid, "Relative_longitude_from_SW_corner_of_bin", &c->pt_dx_id));
+        check_nc_status (nc_inq_varid (c->cdfid, "Relative_latitude_from_SW_corner_of_bin", &c->pt_dy_id));
+
+	/* Get attributes */
+	check_nc_status (nc_get_att_text (c->cdfid, c->pt_dx_id, "units", c->units));
+        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "title", c->title));
+        check_nc_status (nc_get_att_text (c->cdfid, NC_GLOBAL, "source", c->source));
+
+	/* Get global variables */
+
+	start[0] = 0;
+	
+	check_nc_status (nc_get_var1_int (c->cdfid, c->bin_size_id, start, &c->bin_size));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_nx_id, start, &c->bin_nx));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->bin_ny_id, start, &c->bin_ny));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->n_bin_id, start, &c->n_bin));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->n_seg_id, start, &c->n_seg));
+        check_nc_status (nc_get_var1_int (c->cdfid, c->n_pt_id, start, &c->n_pt));
+
+	c->scale = (c->bin_size / 60.0) / 65535.0;
+	c->bsize = c->bin_size / 60.0;
+
+	/* Get bin variables for all bins */
+
+	c->bin_nseg     = (short *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (short), "GMT_br_read_header");
+	c->bin_firstseg     = (int *) GMT_memory (VNULL, (size_t)c->n_bin, sizeof (int), "GMT_br_read_header");
+	
+	count[0] = c->n_bin;
+	check_nc_status (nc_get_vara_short (c->cdfid, c->bin_nseg_id, start, count, c->bin_nseg));
+	check_nc_status (nc_get_vara_int (c->cdfid, c->bin_firstseg_id, start, count, c->bin_firstseg));
+}
+
+int GMT_bin_cache_key (char kind, char res, int bin, int filter[])
+{
+	unsigned int h;
+	
+	h = ((unsigned int)kind * 31 + (unsigned int)res) * 65599 + (unsigned int)bin;
+	h = (h * 31 + (unsigned int)filter[0]) * 31 + (unsigned int)filter[1];
+	h = h * 31 + (unsigned int)filter[2];
+	return ((int)(h % GMT_BIN_CACHE_HASH));
+}
+
+struct GMT_BIN_CACHE *GMT_bin_cache_find (char kind, char res, int bin, int filter[])
+{
+	/* Returns the cached bin decoded with the same selection, or NULL.
+	 * A found entry is marked as in use until GMT_bin_cache_release */
+	 
+	struct GMT_BIN_CACHE *e;
+	
+	for (e = GMT_bin_hash[GMT_bin_cache_key (kind, res, bin, filter)]; e; e = e->hash_next) {
+		if (e->kind != kind || e->res != res || e->bin != bin || e->stale) continue;
+		if (e->filter[0] != filter[0] || e->filter[1] != filter[1] || e->filter[2] != filter[2]) continue;
+		GMT_bin_cache_unlink (e);	/* Move to front of LRU list */
+		GMT_bin_cache_push (e);
+		e->n_users++;
+		GMT_bin_cache_hits++;
+		return (e);
+	}
+	GMT_bin_cache_misses++;
+	return ((struct GMT_BIN_CACHE *)NULL);
+}
+
+struct GMT_BIN_CACHE *GMT_bin_cache_add (char kind, char res, int bin, int filter[], int ns, void *seg, short *arena, size_t bytes)
+{
+	/* Hands a freshly decoded bin over to the cache, marked as in use.  Returns
+	 * NULL if the bin does not fit the budget, in which case the caller keeps seg and arena */
+	 
+	int k;
+	struct GMT_BIN_CACHE *e;
+	
+	if ((long)bytes > GMT_bin_cache_budget) return ((struct GMT_BIN_CACHE *)NULL);
+	
+	e = (struct GMT_BIN_CACHE *) GMT_memory (VNULL, (size_t)1, sizeof (struct GMT_BIN_CACHE), "GMT_bin_cache_add");
+	e->kind = kind;
+	e->res = res;
+	e->bin = bin;
+	for (k = 0; k < 3; k++) e->filter[k] = filter[k];
+	e->ns = ns;
+	e->seg = seg;
+	e->arena = arena;
+	e->bytes = bytes;
+	e->n_users = 1;
+	
+	k = GMT_bin_cache_key (kind, res, bin, filter);
+	e->hash_next = GMT_bin_hash[k];
+	GMT_bin_hash[k] = e;
+	GMT_bin_cache_push (e);
+	GMT_bin_cache_bytes += (long)bytes;
+	GMT_bin_cache_n++;
+	
+	GMT_bin_cache_trim ();
+	
+	return (e);
+}
+
+void GMT_bin_cache_release (struct GMT_BIN_CACHE *e)
+{
+	if (--e->n_users == 0 && e->stale)	/* Flushed while we had it */
+		GMT_bin_cache_evict (e);
+	else
+		GMT_bin_cache_trim ();
+}
+
+void GMT_bin_cache_trim (void)
+{	/* Evicts least recently used bins that are not in use until we are within budget */
+	struct GMT_BIN_CACHE *e, *prev;
+	
+	for (e = GMT_bin_lru_tail; e && GMT_bin_cache_bytes > GMT_bin_cache_budget; e = prev) {
+		prev = e->prev;
+		if (e->n_users == 0) GMT_bin_cache_evict (e);
+	}
+}
+
+void GMT_bin_cache_evict (struct GMT_BIN_CACHE *e)
+{
+	struct GMT_BIN_CACHE **link;
+	
+	for (link = &GMT_bin_hash[GMT_bin_cache_key (e->kind, e->res, e->bin, e->filter)]; *link != e; link = &(*link)->hash_next);
+	*link = e->hash_next;
+	GMT_bin_cache_unlink (e);
+	
+	if (e->arena) GMT_free ((void *)e->arena);
+	if (e->xy) GMT_free ((void *)e->xy);
+	if (e->ns) GMT_free (e->seg);
+	
+	GMT_bin_cache_bytes -= (long)e->bytes;
+	GMT_bin_cache_n--;
+	GMT_free ((void *)e);
+}
+
+void GMT_bin_cache_unlink (struct GMT_BIN_CACHE *e)
+{
+	if (e->prev) e->prev->next = e->next; else GMT_bin_lru_head = e->next;
+	if (e->next) e->next->prev = e->prev; else GMT_bin_lru_tail = e->prev;
+	e->prev = e->next = (struct GMT_BIN_CACHE *)NULL;
+}
+
+void GMT_bin_cache_push (struct GMT_BIN_CACHE *e)
+{
+	e->prev = (struct GMT_BIN_CACHE *)NULL;
+	e->next = GMT_bin_lru_head;
+	if (GMT_bin_lru_head) GMT_bin_lru_head->prev = e; else GMT_bin_lru_tail = e;
+	GMT_bin_lru_head = e;
+}
+
+struct GMT_BIN_CACHE *GMT_stitch_cache_find (char kind, char res, int filter[], double box[])
+{
+	/* Returns the lines GMT_stitch_lines made of the bins tiling box, or NULL.
+	 * They share the budget and LRU list of the bins, with bin -1 */
+
+	int k;
+	struct GMT_BIN_CACHE *e;
+
+	GMT_shore_lock ();
+	for (e = GMT_bin_hash[GMT_bin_cache_key (kind, res, -1, filter)]; e; e = e->hash_next) {
+		if (e->kind != kind || e->res != res || e->bin != -1 || e->stale) continue;
+		if (e->filter[0] != filter[0] || e->filter[1] != filter[1] || e->filter[2] != filter[2]) continue;
+		for (k = 0; k < 4 && e->box[k] == box[k]; k++);
+		if (k < 4) continue;
+		GMT_bin_cache_unlink (e);
+		GMT_bin_cache_push (e);
+		e->n_users++;
+		GMT_bin_cache_hits++;
+		GMT_shore_unlock ();
+		return (e);
+	}
+	GMT_bin_cache_misses++;
+	GMT_shore_unlock ();
+	return ((struct GMT_BIN_CACHE *)NULL);
+}
+
+struct GMT_BIN_CACHE *GMT_stitch_cache_add (char kind, char res, int filter[], double box[], int n, struct POL *line, double *xy, int n_pieces)
+{
+	/* Hands stitched lines over to the cache, marked as in use.  Returns NULL
+	 * if they do not fit the budget, in which case the caller keeps line and xy */
+
+	int i;
+	size_t bytes;
+	struct GMT_BIN_CACHE *e;
+
+	for (i = 0, bytes = sizeof (struct GMT_BIN_CACHE) + n * sizeof (struct POL); i < n; i++) bytes += 2 * line[i].n * sizeof (double);
+
+	GMT_shore_lock ();
+	e = GMT_bin_cache_add (kind, res, -1, filter, n, (void *)line, (short *)NULL, bytes);
+	if (e) {
+		memcpy ((void *)e->box, (void *)box, 4 * sizeof (double));
+		e->xy = xy;
+		e->n_pieces = n_pieces;
+	}
+	GMT_shore_unlock ();
+	return (e);
+}
+
+void GMT_stitch_cache_release (struct GMT_BIN_CACHE *e)
+{
+	GMT_shore_lock ();
+	GMT_bin_cache_release (e);
+	GMT_shore_unlock ();
+}
+
+
 int GMT_copy_to_shore_path (double *lon, double *lat, struct GMT_SHORE *s, int id)
 {
 	int i;
@@ -69,6 +69,8 @@
  *	GMT_intpol		1-D interpolation
  *	GMT_memory		Memory allocation/reallocation
  *	GMT_free		Memory deallocation
+ *	GMT_arena_alloc		Memory from an arena, given back all at once by GMT_arena_reset
+ *	GMT_arena_grow		Enlarges a piece of arena memory
  *	GMT_median		Finds the median without sorting
  *	GMT_non_zero_winding	Finds if a point is inside/outside a polygon
  *	GMT_read_cpt		Read color palette file
@@ -1049,6 +1051,108 @@ void GMT_free (void *addr)
 	free (addr);
 }
 
+/*
+ * An arena hands out memory from a few large blocks and takes all of it back
+ * at once with GMT_arena_reset, so work that makes and drops many small
+ * arrays (like the polygons of one shoreline bin) need not go to malloc for
+ * each.  After a reset the arena keeps a single block large enough for all
+ * it handed out before, so a reused arena soon needs no new memory at all.
+ * Every function takes a NULL arena to mean plain GMT_memory and GMT_free.
+ */
+
+void *GMT_arena_alloc (struct GMT_ARENA *A, size_t nelem, size_t size)
+{
+	/* Like GMT_memory (VNULL, nelem, size), but the memory is not cleared */
+
+	size_t bytes, want;
+	char *b;
+
+	if (!A) return (GMT_memory (VNULL, nelem, size, "GMT_arena_alloc"));
+	if (nelem == 0) return (VNULL);
+
+	bytes = (nelem * size + GMT_ARENA_ALIGN - 1) & ~((size_t)GMT_ARENA_ALIGN - 1);
+	if (!A->block || A->used + bytes > A->size) {	/* Start a new block; the full one is kept until the reset */
+		want = MAX (GMT_ARENA_BLOCK, 2 * (bytes + GMT_ARENA_ALIGN));
+		b = (char *) GMT_memory (VNULL, want, (size_t)1, "GMT_arena_alloc");
+		*(char **)b = A->block;
+		A->block = b;
+		A->size = want;
+		A->used = GMT_ARENA_ALIGN;
+		A->n_block++;
+	}
+	A->last = A->used;
+	A->used += bytes;
+	A->total += bytes;
+	A->n_alloc++;
+	return ((void *)(A->block + A->last));
+}
+
+void *GMT_arena_grow (struct GMT_ARENA *A, void *ptr, size_t old_nelem, size_t nelem, size_t size)
+{
+	/* Like GMT_memory (ptr, nelem, size) for a piece of old_nelem elements.
+	 * The newest piece grows in place while the block has room; others are
+	 * copied, so callers should grow geometrically.  Pieces never shrink */
+
+	size_t bytes, old_bytes;
+	void *tmp;
+
+	if (!A) return (GMT_memory (ptr, nelem, size, "GMT_arena_grow"));
+	if (!ptr) return (GMT_arena_alloc (A, nelem, size));
+
+	old_bytes = (old_nelem * size + GMT_ARENA_ALIGN - 1) & ~((size_t)GMT_ARENA_ALIGN - 1);
+	bytes = (nelem * size + GMT_ARENA_ALIGN - 1) & ~((size_t)GMT_ARENA_ALIGN - 1);
+	if (bytes <= old_bytes) return (ptr);
+
+	if ((char *)ptr == A->block + A->last && A->last + bytes <= A->size) {	/* Extend in place */
+		A->used = A->last + bytes;
+		A->total += bytes - old_bytes;
+		return (ptr);
+	}
+	tmp = GMT_arena_alloc (A, nelem, size);
+	memcpy (tmp, ptr, old_nelem * size);
+	return (tmp);
+}
+
+void GMT_arena_release (struct GMT_ARENA *A, void *ptr)
+{
+	/* GMT_free for memory from GMT_arena_alloc; arena pieces wait for the reset */
+
+	if (!A) GMT_free (ptr);
+}
+
+void GMT_arena_reset (struct GMT_ARENA *A)
+{
+	/* Takes back everything handed out.  If that took several blocks they
+	 * are replaced by one that holds it all */
+
+	size_t want;
+
+	if (!A->block) return;
+	if (*(char **)A->block) {
+		want = A->total + GMT_ARENA_ALIGN;
+		GMT_arena_free (A);
+		A->block = (char *) GMT_memory (VNULL, want, (size_t)1, "GMT_arena_reset");
+		A->size = want;
+		A->n_block++;
+	}
+	A->used = GMT_ARENA_ALIGN;
+	A->last = A->total = 0;
+	A->n_reset++;
+}
+
+void GMT_arena_free (struct GMT_ARENA *A)
+{
+	/* Gives the blocks back to the system.  The counts are kept */
+
+	char *b;
+
+	while ((b = A->block)) {
+		A->block = *(char **)b;
+		GMT_free ((void *)b);
+	}
+	A->size = A->used = A->last = A->total = 0;
+}
+
 #define CONTOUR_IJ(i,j) ((i) + (j) * nx)
 
 int GMT_contours (float *grd, struct GRD_HEADER *header, int smooth_factor, int int_scheme, int *side, int *edge, int first, double **x_array, double **y_array)
@@ -300,6 +300,20 @@ struct XINGS {
         int nx;                 /* Number of intersections (1 or 2) */
 };
 
+#define GMT_ARENA_BLOCK	65536	/* Smallest block of a GMT_ARENA, in bytes */
+#define GMT_ARENA_ALIGN	16	/* Pieces of a GMT_ARENA start on multiples of this */
+
+struct GMT_ARENA {	/* Memory handed out piece by piece and taken back all at once, see GMT_arena_alloc */
+	char *block;		/* Current block; its first bytes point to the block filled before it */
+	size_t size;		/* Bytes in the current block */
+	size_t used;		/* Bytes of it handed out */
+	size_t last;		/* Offset of the newest piece, which GMT_arena_grow extends in place */
+	size_t total;		/* Bytes handed out since the last reset, over all blocks */
+	long n_alloc;		/* Pieces handed out */
+	long n_block;		/* Blocks obtained from GMT_memory */
+	long n_reset;		/* Calls to GMT_arena_reset */
+};
+
 struct BCR {	/* Used mostly in gmt_support.c */
 	double	nodal_value[4][4];	/* z, dz/dx, dz/dy, d2z/dxdy at 4 corners  */
 	double	bcr_basis[4][4];	/* multiply on nodal vals, yields z at point */
@@ -405,6 +419,8 @@ EXTERN_MSC BOOLEAN GMT_parallel_straight;	/* TRUE if parallels plot as straight
 /*--------------------------------------------------------------------*/
 
 EXTERN_MSC struct MAP_PROJECTIONS project_info;
+EXTERN_MSC struct GMT_PROJ_BLOCK GMT_proj_block;	/*	Constants for the array kernels, see GMT_set_proj_block */
+EXTERN_MSC BOOLEAN GMT_fast_trig;	/*	TRUE to set up projections with polynomial trig, see GMT_set_fast_trig */
 EXTERN_MSC struct THREE_D z_project;
 EXTERN_MSC PFI GMT_forward, GMT_inverse;	/*	Pointers to the selected mapping functions */
 EXTERN_MSC PFI GMT_x_forward, GMT_x_inverse;	/*	Pointers to the selected linear functions */
@@ -35,7 +35,15 @@ EXTERN_MSC void GMT_z_to_zz (double z, double *zz);
 EXTERN_MSC void GMT_zz_to_z (double *z, double zz);
 EXTERN_MSC void *GMT_memory (void *prev_addr, size_t nelem, size_t size, char *progname);
 EXTERN_MSC void GMT_free (void *addr);
+EXTERN_MSC void *GMT_arena_alloc (struct GMT_ARENA *A, size_t nelem, size_t size);
+EXTERN_MSC void *GMT_arena_grow (struct GMT_ARENA *A, void *ptr, size_t old_nelem, size_t nelem, size_t size);
+EXTERN_MSC void GMT_arena_release (struct GMT_ARENA *A, void *ptr);
+EXTERN_MSC void GMT_arena_reset (struct GMT_ARENA *A);
+EXTERN_MSC void GMT_arena_free (struct GMT_ARENA *A);
 EXTERN_MSC double GMT_great_circle_dist (double lon1, double lat1, double lon2, double lat2);
+EXTERN_MSC void GMT_great_circle_dist_array (double *lon1, double *lat1, double *lon2, double *lat2, double *dist, double *az, int n);
+EXTERN_MSC void GMT_great_circle_dist_one (double lon0, double lat0, double *lon, double *lat, double *dist, double *az, int n);
+EXTERN_MSC void GMT_great_circle_dist_matrix (double *lon1, double *lat1, int n1, double *lon2, double *lat2, int n2, double *dist, double *az);
 EXTERN_MSC double GMT_half_map_width (double y);
 EXTERN_MSC double GMT_dot3v (double *a, double *b);
 EXTERN_MSC double GMT_ddmmss_to_degree (char *text);
@@ -54,6 +62,10 @@ EXTERN_MSC int GMT_savedefaults (char *file);
 EXTERN_MSC void GMT_default_error (char option);
 EXTERN_MSC void GMT_explain_option (char option);
 EXTERN_MSC void GMT_map_setup (double west, double east, double south, double north);
+EXTERN_MSC BOOLEAN GMT_setup_cache_get (char *key, char *jarg, double west, double east, double south, double north);
+EXTERN_MSC void GMT_setup_cache_put (char *key);
+EXTERN_MSC void GMT_setup_cache_stats (long stats[3]);
+EXTERN_MSC void GMT_setup_cache_flush (void);
 EXTERN_MSC int GMT_map_getproject (char *args);
 EXTERN_MSC void GMT_geoplot (double lon, double lat, int pen);
 EXTERN_MSC void GMT_hash_init (struct GMT_HASH *hashnode , char **keys, int n_hash, int n_keys);
@@ -67,13 +79,19 @@ EXTERN_MSC void GMT_xy_do_z_to_xy (double x, double y, double z, double *x_out,
 EXTERN_MSC int GMT_intpol (double *x, double *y, int n, int m, double *u, double *v, int mode);
 EXTERN_MSC int GMT_map_outside (double lon, double lat);
 EXTERN_MSC void GMT_get_plot_array (void);
-EXTERN_MSC int GMT_graticule_path (double **x, double **y, int dir, double w, double e, double s, double n);
-EXTERN_MSC int GMT_map_path (double lon1, double lat1, double lon2, double lat2, double **x, double **y);
-EXTERN_MSC int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y);
-EXTERN_MSC int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y);
+EXTERN_MSC int GMT_graticule_path (double **x, double **y, int dir, BOOLEAN straight, double w, double e, double s, double n, struct GMT_ARENA *A);
+EXTERN_MSC int GMT_map_path (double lon1, double lat1, double lon2, double lat2, BOOLEAN straight, double **x, double **y, struct GMT_ARENA *A);
+EXTERN_MSC int GMT_latpath (double lat, double lon1, double lon2, double **x, double **y, struct GMT_ARENA *A);
+EXTERN_MSC int GMT_lonpath (double lon, double lat1, double lat2, double **x, double **y, struct GMT_ARENA *A);
 EXTERN_MSC int GMT_get_format (double interval, char *unit, char *format);
 EXTERN_MSC void GMT_geo_to_xy (double lon, double lat, double *x, double *y);
 EXTERN_MSC void GMT_xy_to_geo (double *lon, double *lat, double x, double y);
+EXTERN_MSC void GMT_geo_to_xy_array (double *lon, double *lat, double *x, double *y, int n);
+EXTERN_MSC void GMT_xy_to_geo_array (double *x, double *y, double *lon, double *lat, int n);
+EXTERN_MSC void GMT_forward_array (double *lon, double *lat, double *x, double *y, int n);
+EXTERN_MSC int GMT_inverse_array (double *x, double *y, double *lon, double *lat, char *ok, int n);
+EXTERN_MSC void GMT_lat_swap_init (void);
+EXTERN_MSC void GMT_lat_swap_array (double *lat, double *out, int n, int itype, BOOLEAN table);
 EXTERN_MSC int GMT_break_through (double x0, double y0, double x1, double y1);
 EXTERN_MSC int GMT_map_crossing (double lon1, double lat1, double lon2, double lat2, double *xlon, double *xlat, double *xx, double *yy, int *sides);
 EXTERN_MSC void GMT_vertical_axis (int mode);
@@ -82,10 +100,12 @@ EXTERN_MSC int GMT_map_clip_path (double **x, double **y, BOOLEAN *donut);
 EXTERN_MSC int GMT_fix_up_path (double **a_lon, double **a_lat, int n, BOOLEAN greenwich, double step);
 EXTERN_MSC int GMT_clip_to_map (double *lon, double *lat, int np, double **x, double **y);
 EXTERN_MSC int GMT_compact_line (double *x, double *y, int n, BOOLEAN pen_flag, int *pen);
+EXTERN_MSC int GMT_simplify_line (double *x, double *y, int n, double tolerance, char *keep);
 EXTERN_MSC void GMT_plot_line (double *x, double *y, int *pen, int n);
 EXTERN_MSC void GMT_2D_to_3D (double *x, double *y, int n);
 EXTERN_MSC void GMT_xyz_to_xy (double x, double y, double z, double *x_out, double *y_out);
 EXTERN_MSC int GMT_geo_to_xy_line (double *lon, double *lat, int n);
+EXTERN_MSC int GMT_geo_to_xy_line_xy (double *lon, double *lat, double *x, double *y, int n);
 EXTERN_MSC int GMT_grd_get_i_format (char *file, char *fname, double *scale, double *offset);
 EXTERN_MSC int GMT_grd_get_o_format (char *file, char *fname, double *scale, double *offset);
 EXTERN_MSC void GMT_grd_init (struct GRD_HEADER *header, int argc, char **argv, BOOLEAN update);
@@ -110,6 +110,8 @@ BOOLEAN GMT_continuous;		/* TRUE if continuous color tables have been given */
 /*--------------------------------------------------------------------*/
 
 struct MAP_PROJECTIONS project_info;
+struct GMT_PROJ_BLOCK GMT_proj_block;	/*	Constants for the array kernels, see GMT_set_proj_block */
+BOOLEAN GMT_fast_trig = FALSE;	/*	TRUE to set up projections with polynomial trig, see GMT_set_fast_trig */
 struct THREE_D z_project;
 PFI GMT_forward, GMT_inverse;		/*	Pointers to the selected mapping functions */
 PFI GMT_x_forward, GMT_x_inverse;	/*	Pointers to the selected linear functions */
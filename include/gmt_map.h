@@ -36,13 +36,46 @@
 #define GMT_LATSWAP_P2O 11	/* input = parametric; output = geocentric */
 #define GMT_LATSWAP_N	12	/* number of defined swaps  */
 
+#define GMT_LATSWAP_TAB_SCL	16.0	/* Lookup table nodes per degree of latitude  */
+#define GMT_LATSWAP_TAB_N	1440	/* Lookup table intervals over 0-90 degrees  */
+
 struct GMT_LATSWAP_CONSTS {
 	double  c[GMT_LATSWAP_N][4];	/* Coefficients in 4-term series  */
 	double	ra;			/* Authalic   radius (sphere for equal-area)  */
 	double	rm;			/* Meridional radius (sphere for N-S distance)  */
 	BOOLEAN spherical;		/* True if no conversions need to be done.  */
+	double	*tab[GMT_LATSWAP_N];	/* Lookup tables made by GMT_lat_swap_table, or NULL  */
+	double	tab_c[GMT_LATSWAP_N][4];	/* Coefficients each table was made from  */
 } GMT_lat_swap_vals;
 
+#define GMT_SETUP_PROBE		4	/* Slots of the setup cache a key may go in */
+
+#ifdef GMT_THREADS
+#define GMT_setup_cache_lock()		pthread_mutex_lock (&GMT_setup_cache_mutex)
+#define GMT_setup_cache_unlock()	pthread_mutex_unlock (&GMT_setup_cache_mutex)
+#else
+#define GMT_setup_cache_lock()
+#define GMT_setup_cache_unlock()
+#endif
+
+struct GMT_SETUP_STATE {	/* What GMT_map_getproject and GMT_map_setup leave behind, for GMT_setup_cache_get */
+	char key[GMT_SETUP_KEY_LEN];	/* -J argument, region, -R...r, ellipsoid and fast trig */
+	long used;			/* Hits and misses of the cache when last used */
+	struct MAP_PROJECTIONS project_info;
+	struct MAP_FRAME frame_info;
+	struct GMTDEFAULTS gmtdefs;
+	struct THREE_D z_project;
+	struct GMT_PROJ_BLOCK proj_block;
+	PFI forward, inverse, x_forward, x_inverse, y_forward, y_inverse, z_forward, z_inverse;
+	PFI outside, crossing, overlap, map_clip, wrap_around_check, map_jump, truncate;
+	PFD left_edge, right_edge;
+	PFB will_it_wrap, this_point_wraps;
+	PFV get_crossings;
+	BOOLEAN world_map, world_map_tm, meridian_straight, parallel_straight, convert_latitudes;
+	int corner;
+	double map_width, map_height, half_map_size, half_map_height;
+};
+
 /* Some shorthand notation for GMT specific cases */
 
 #define GMT_latg_to_latc(lat) GMT_lat_swap_quick (lat, GMT_lat_swap_vals.c[GMT_LATSWAP_G2C])
@@ -53,3 +86,4 @@ struct GMT_LATSWAP_CONSTS {
 void GMT_lat_swap_init (void);
 double	GMT_lat_swap_quick (double lat, double c[]);
 double	GMT_lat_swap (double lat, int itype);
+double	*GMT_lat_swap_table (int itype);
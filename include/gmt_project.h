@@ -65,6 +65,24 @@
 #define D2R (M_PI / 180.0)
 #define R2D (180.0 / M_PI)
 
+#define GMT_SETUP_KEY_LEN	256	/* Longest key of the map setup cache, see GMT_setup_cache_get */
+
+/* project_info, gmtdefs and the function pointers hold one map projection for
+ * the whole process.  With GMT_THREADS a thread sets one up and uses it while
+ * holding the projection lock, which may be taken again by the same thread */
+
+#ifdef GMT_THREADS
+#include <pthread.h>
+EXTERN_MSC pthread_mutex_t GMT_project_mutex;
+EXTERN_MSC pthread_once_t GMT_project_once;
+EXTERN_MSC void GMT_project_mutex_init (void);
+#define GMT_project_lock()	(pthread_once (&GMT_project_once, GMT_project_mutex_init), pthread_mutex_lock (&GMT_project_mutex))
+#define GMT_project_unlock()	pthread_mutex_unlock (&GMT_project_mutex)
+#else
+#define GMT_project_lock()
+#define GMT_project_unlock()
+#endif
+
 struct MAP_PROJECTIONS {
 
 	double pars[10];		/* Raw unprocessed map-projection parameters as passed on command line */
@@ -221,6 +239,23 @@ struct MAP_PROJECTIONS {
 	
 };
 
+struct GMT_PROJ_BLOCK {		/* Constants of the current projection, copied from project_info and
+				 * gmtdefs by GMT_set_proj_block after setup and only read afterwards.
+				 * Kept together so the array kernels touch a few cache lines */
+
+	double cm;			/* Central meridian */
+	double R, k0;			/* Equatorial radius and map scale factor */
+	double e, e2, half_e, i_half_e;	/* Eccentricity terms */
+	double one_m_e2, i_one_m_e2;
+
+	double n, i_n, nr;		/* Conics: cone constant, its inverse, and per degree (Lambert) */
+	double F, C, rho0;		/* Lambert rF or Albers C, and radius at the origin */
+
+	double ep2, lat0, M0;		/* TM and Cassini: e'^2, origin latitude (radians) and its meridian distance */
+	double c[4];			/* Meridian distance series */
+	double i[5];			/* and its inverse */
+};
+
 struct MAP_FRAME {		/* Various parameters for plotting of map boundaries */
 	double frame_int[3];	/* x,y,z */
 	double grid_int[3];
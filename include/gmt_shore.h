@@ -32,6 +32,30 @@
 #define N_BLEVELS	3	/* Number of levels for borders */
 #define N_RLEVELS	10	/* Number of levels for rivers */
 
+#define GMT_BIN_CACHE_SIZE	16777216	/* Default memory budget for decoded bins [16 Mb] */
+#define GMT_BIN_CACHE_HASH	1021		/* Number of hash buckets in the bin cache */
+
+#ifdef GMT_THREADS
+#include <pthread.h>
+EXTERN_MSC pthread_mutex_t GMT_shore_mutex;
+#define GMT_shore_lock()	pthread_mutex_lock (&GMT_shore_mutex)
+#define GMT_shore_unlock()	pthread_mutex_unlock (&GMT_shore_mutex)
+#else
+#define GMT_shore_lock()
+#define GMT_shore_unlock()
+#endif
+
+#define GMT_SHORE_MAGIC		"GMTSHBIN"	/* First 8 bytes of a compact binned_*.bin database */
+#define GMT_SHORE_VERSION	1		/* Current version of the compact format */
+#define GMT_SHORE_BYTE_ORDER	0x01020304	/* Written in native order to detect foreign files */
+#define GMT_SHORE_INDEX_MAGIC	"GMTSHIDX"	/* First 8 bytes of a binned_*.idx bin index */
+#define GMT_SHORE_INDEX_VERSION	1		/* Current version of the index format */
+#define GMT_SHORE_RANK_MAGIC	"GMTSHRNK"	/* First 8 bytes of a binned_*.rnk point ranking */
+#define GMT_SHORE_RANK_VERSION	1		/* Current version of the ranking format */
+#define GMT_SHORE_RANK_KEEP	255		/* Rank of points that are never thinned away */
+
+struct GMT_SHORE_DB;
+
 struct GMT_SHORE {
 
 	/* Global variables that remain fixed for all bins */
@@ -48,7 +72,12 @@ struct GMT_SHORE {
 	struct SIDE *side[4];		/* Has position & id for each side exit/entry */
 	int nside[4];			/* Number of entries per side, including corner */
 	int n_entries;
+	struct GMT_BIN_CACHE *cache;	/* Cache entry holding seg, or NULL if seg belongs to us */
+	short *arena;			/* Holds dx then dy of all segments in the bin */
 	BOOLEAN leftmost_bin;		/* TRUE if current bin is at left edge of map */
+	BOOLEAN world_map;		/* TRUE if the region wraps around in longitude */
+	BOOLEAN straight;		/* TRUE if bin edges are straight in lon/lat, see GMT_assemble_shore */
+	double west;			/* West boundary of the region */
 	double bsize;			/* Size of square bins in degrees */
 	double lon_sw;			/* Longitude of SW corner */
 	double lat_sw;			/* Latitude of SW corner */
@@ -57,6 +86,7 @@ struct GMT_SHORE {
 
 	/* Data variables associated with shoreline database */
 	
+	char res;		/* Resolution of the data set (f, h, i, l, c) */
 	int bin_size;	/* Size of square bins in minutes */
 	int bin_nx;		/* Number of bins in 360 degrees of longitude */
 	int bin_ny;		/* Number of bins in 180 degrees of latitude */
@@ -68,10 +98,33 @@ struct GMT_SHORE {
 	short *bin_info;	/* Array with levels of all 4 nodes per bin */
 	short *bin_nseg;	/* Array with number of segments per bin */
 	
+	/* Bin index, from binned_*.idx or the compact database; NULL if neither is present */
+	
+	int *bin_npt;		/* Array with number of points per bin */
+	unsigned char *bin_used;	/* Bit set for every bin of the data set that has segments */
+	int top_level;		/* Highest segment level in the data set */
+	
 	char units[80];		/* Units of lon/lat */
 	char title[80];		/* Title of data set */
 	char source[80];	/* Source of data set */
 
+	/* Compact database mapped into memory, used instead of netcdf if present */
+	
+	char *map;		/* Start of mapping, or NULL when reading netcdf */
+	size_t map_size;	/* Length of mapping in bytes */
+	struct GMT_SHORE_FILE_SEG *map_seg;	/* Segment table in the mapping */
+	short *map_pt;		/* Point blocks in the mapping */
+
+	/* Point ranks mapped from binned_*.rnk, used to thin segments while they are read */
+	
+	char *rank_map;		/* Start of mapping, or NULL if there are no ranks */
+	size_t rank_map_size;	/* Length of mapping in bytes */
+	int *rank_start;	/* Offset of the ranks of every segment */
+	unsigned char *rank;	/* Rank of every point, see GMT_shore_rank */
+	double tolerance;	/* Points that matter less than this (in degrees) are skipped [0 keeps all] */
+
+	struct GMT_SHORE_DB *db;	/* Database the reader was opened on by GMT_init_shore or GMT_init_br, or NULL */
+
 	/* Netcdf ID variables */
 	
 	int cdfid;		/* File id for coastbin file */
@@ -121,12 +174,16 @@ struct GMT_BR {	/* Structure for Borders and Rivers */
 	
 	int ns;			/* Number of segments to use in current bin */
 	struct GMT_BR_SEGMENT *seg;	/* Array of these segments */
+	struct GMT_BIN_CACHE *cache;	/* Cache entry holding seg, or NULL if seg belongs to us */
+	short *arena;			/* Holds dx then dy of all segments in the bin */
 	double lon_sw;		/* Longitude of SW corner */
 	double lat_sw;		/* Latitude of SW corner */
 	double bsize;		/* Size of square bins in degrees */
 
 	/* Data variables associated with shoreline database */
 	
+	char which;		/* Data set: r(iver) or b(order) */
+	char res;		/* Resolution of the data set (f, h, i, l, c) */
 	int bin_size;	/* Size of square bins in minutes */
 	int bin_nx;		/* Number of bins in 360 degrees of longitude */
 	int bin_ny;		/* Number of bins in 180 degrees of latitude */
@@ -137,10 +194,33 @@ struct GMT_BR {	/* Structure for Borders and Rivers */
 	int *bin_firstseg;	/* Array with ids of first segment per bin */
 	short *bin_nseg;	/* Array with number of segments per bin */
 	
+	/* Bin index, from binned_*.idx or the compact database; NULL if neither is present */
+	
+	int *bin_npt;		/* Array with number of points per bin */
+	unsigned char *bin_used;	/* Bit set for every bin of the data set that has segments */
+	int top_level;		/* Highest segment level in the data set */
+	
 	char units[80];		/* Units of lon/lat */
 	char title[80];		/* Title of data set */
 	char source[80];	/* Source of data set */
 
+	/* Compact database mapped into memory, used instead of netcdf if present */
+	
+	char *map;		/* Start of mapping, or NULL when reading netcdf */
+	size_t map_size;	/* Length of mapping in bytes */
+	struct GMT_SHORE_FILE_SEG *map_seg;	/* Segment table in the mapping */
+	short *map_pt;		/* Point blocks in the mapping */
+
+	/* Point ranks mapped from binned_*.rnk, used to thin segments while they are read */
+	
+	char *rank_map;		/* Start of mapping, or NULL if there are no ranks */
+	size_t rank_map_size;	/* Length of mapping in bytes */
+	int *rank_start;	/* Offset of the ranks of every segment */
+	unsigned char *rank;	/* Rank of every point, see GMT_shore_rank */
+	double tolerance;	/* Points that matter less than this (in degrees) are skipped [0 keeps all] */
+
+	struct GMT_SHORE_DB *db;	/* Database the reader was opened on by GMT_init_shore or GMT_init_br, or NULL */
+
 	/* Netcdf ID variables */
 	
 	int cdfid;		/* File id for coastbin file */
@@ -170,6 +250,99 @@ struct GMT_BR_SEGMENT {
 	short *dy;		/* Array of scaled latitudes relative to SW corner */
 };
 
+struct GMT_BIN_CACHE {	/* A decoded bin kept in the process-wide bin cache */
+	char kind;		/* 'c' for shorelines, 'b' for borders, 'r' for rivers */
+	char res;		/* Resolution (f, h, i, l, c) */
+	int bin;		/* Bin number in the data set */
+	int filter[3];		/* Selection used when decoding (cut_area, min_level, max_level or level mask), with the min rank << 8 in filter[1] */
+	int ns;			/* Number of segments kept */
+	void *seg;		/* Array of GMT_SHORE_SEGMENT or GMT_BR_SEGMENT structures */
+	short *arena;		/* dx and dy of all segments, or NULL if they point into a mapped database */
+	size_t bytes;		/* Memory held by this entry */
+	int n_users;		/* Number of readers currently using seg */
+	BOOLEAN stale;		/* TRUE if flushed while in use; evicted when the last user lets go */
+	double box[4];		/* Bin-aligned region of stitched lines, whose bin is -1 */
+	double *xy;		/* Coordinates of stitched lines, or NULL */
+	int n_pieces;		/* Number of pieces the stitched lines were made of */
+	struct GMT_BIN_CACHE *prev, *next;	/* LRU list, most recently used first */
+	struct GMT_BIN_CACHE *hash_next;	/* Next entry in the same hash bucket */
+};
+
+/* Layout of the compact binned_*.bin databases written by GMT_shore_convert.  The file is
+ * the header, the bin directory (n_bin entries), the segment table (n_seg entries) and
+ * then one block per segment holding its n dx values followed by its n dy values.
+ * All values are in native byte order. */
+
+struct GMT_SHORE_FILE_HEADER {
+	char magic[8];		/* GMT_SHORE_MAGIC */
+	int version;		/* GMT_SHORE_VERSION */
+	int byte_order;		/* GMT_SHORE_BYTE_ORDER */
+	int kind;		/* 'c' for shorelines, 'b' for borders, 'r' for rivers */
+	int bin_size;		/* Size of square bins in minutes */
+	int bin_nx;		/* Number of bins in 360 degrees of longitude */
+	int bin_ny;		/* Number of bins in 180 degrees of latitude */
+	int n_bin;		/* Number of bins in the file */
+	int n_seg;		/* Number of segments in the file */
+	int n_pt;		/* Number of points in the file */
+	char units[80];		/* Units of lon/lat */
+	char title[80];		/* Title of data set */
+	char source[80];	/* Source of data set */
+};
+
+struct GMT_SHORE_FILE_BIN {
+	short info;		/* Levels of the 4 nodes (shorelines only) */
+	short nseg;		/* Number of segments in bin */
+	int firstseg;		/* Id of first segment in bin */
+};
+
+struct GMT_SHORE_FILE_SEG {
+	int info;		/* Embedded npts/levels/exit/entry for shorelines, npts for borders and rivers */
+	int area;		/* Ten times area of parent polygon for shorelines, level for borders and rivers */
+	int start;		/* Point offset of the segment; its block starts at 2 * start */
+};
+
+/* Layout of the binned_*.rnk point ranking written by GMT_shore_rank: the header, the
+ * offset of the ranks of every segment (n_seg ints) and one rank per point (n_rank bytes).
+ * A rank is the effective area of the point, in squared dx/dy units, on a log scale of
+ * four steps per doubling (see GMT_shore_rank_of); segment ends get GMT_SHORE_RANK_KEEP */
+
+struct GMT_SHORE_RANK_HEADER {
+	char magic[8];		/* GMT_SHORE_RANK_MAGIC */
+	int version;		/* GMT_SHORE_RANK_VERSION */
+	int byte_order;		/* GMT_SHORE_BYTE_ORDER */
+	int kind;		/* 'c' for shorelines, 'b' for borders, 'r' for rivers */
+	int n_bin;		/* Number of bins, segments and points in the netcdf */
+	int n_seg;		/*   database the ranks were made from */
+	int n_pt;
+	int n_rank;		/* Number of points ranked, which is all points in use */
+};
+
+/* Layout of the binned_*.idx bin index written by GMT_shore_index: the header, the number
+ * of points per bin (n_bin ints), the number of segments per bin (n_bin shorts) and the
+ * occupancy bitmap ((n_bin + 7) / 8 bytes, bin i is bit i % 8 of byte i / 8). */
+
+struct GMT_SHORE_INDEX_HEADER {
+	char magic[8];		/* GMT_SHORE_INDEX_MAGIC */
+	int version;		/* GMT_SHORE_INDEX_VERSION */
+	int byte_order;		/* GMT_SHORE_BYTE_ORDER */
+	int kind;		/* 'c' for shorelines, 'b' for borders, 'r' for rivers */
+	int n_bin;		/* Number of bins, segments and points in the database */
+	int n_seg;		/*   the index was made from; it is ignored unless */
+	int n_pt;		/*   they all match */
+	int n_used;		/* Number of bins with segments */
+	int top_level;		/* Highest segment level */
+};
+
+struct GMT_SHORE_DB {	/* Header of an open database, kept until GMT_shore_cache_flush */
+	char kind;		/* 'c' for shorelines, 'b' for borders, 'r' for rivers */
+	char res;		/* Resolution (f, h, i, l, c) */
+	struct GMT_SHORE shore;	/* Ids and full-size bin arrays if kind is 'c' */
+	struct GMT_BR br;	/* Ids and full-size bin arrays otherwise */
+	int n_readers;		/* Readers opened on it and not yet cleaned up */
+	BOOLEAN flushed;	/* TRUE once GMT_shore_cache_flush dropped it; closed with its last reader */
+	struct GMT_SHORE_DB *next;
+};
+
 struct POL {
 	int n;
 	int interior;	/* TRUE if polygon is inside bin */
@@ -178,6 +351,14 @@ struct POL {
 	double *lat;
 };
 
+struct GMT_SHORE_OUTLINE {	/* Bin-aligned region polygons are closed along, see GMT_merge_shore */
+	double w, e, s, n;	/* Its edges */
+	double width, height;	/* And size, in degrees */
+	double perimeter;	/* Length of the outline, counterclockwise from the SW corner */
+	double step;		/* Distance between points added along the outline (a bin) */
+	double tol;		/* Points closer than this are the same */
+};
+
 /* Public functions */
 
 EXTERN_MSC void GMT_get_shore_bin (int b, struct GMT_SHORE *c, double min_area, int min_level, int max_level);
@@ -189,7 +370,21 @@ EXTERN_MSC void GMT_shore_cleanup (struct GMT_SHORE *c);
 EXTERN_MSC void GMT_br_cleanup (struct GMT_BR *c);
 EXTERN_MSC int GMT_init_shore (char res, struct GMT_SHORE *c, double w, double e, double s, double n);
 EXTERN_MSC int GMT_init_br (char which, char res, struct GMT_BR *c, double w, double e, double s, double n);
-EXTERN_MSC int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN assemble, BOOLEAN shift, double west, double east, struct POL **pol);
-EXTERN_MSC int GMT_assemble_br (struct GMT_BR *c, BOOLEAN shift, double edge, struct POL **pol);
+EXTERN_MSC int GMT_assemble_shore (struct GMT_SHORE *c, int dir, int first_level, BOOLEAN assemble, BOOLEAN shift, double west, double east, struct POL **pol, struct GMT_ARENA *A);
+EXTERN_MSC int GMT_merge_shore (struct POL *p, int np, int dir, int first_level, int corner_level, struct GMT_SHORE_OUTLINE *B, struct POL **pol);
+EXTERN_MSC int GMT_stitch_lines (struct POL *p, int np, struct GMT_SHORE_OUTLINE *B, struct POL **line, double **xy);
+EXTERN_MSC struct GMT_BIN_CACHE *GMT_stitch_cache_find (char kind, char res, int filter[], double box[]);
+EXTERN_MSC struct GMT_BIN_CACHE *GMT_stitch_cache_add (char kind, char res, int filter[], double box[], int n, struct POL *line, double *xy, int n_pieces);
+EXTERN_MSC void GMT_stitch_cache_release (struct GMT_BIN_CACHE *e);
+EXTERN_MSC int GMT_assemble_br (struct GMT_BR *c, BOOLEAN shift, double edge, struct POL **pol, struct GMT_ARENA *A);
 EXTERN_MSC int GMT_prep_polygons (struct POL **p, int np, BOOLEAN greenwich, BOOLEAN sample, double step, int anti_bin);
 EXTERN_MSC int GMT_set_resolution (char *res, char opt);
+EXTERN_MSC char GMT_shore_pick_resolution (char kind, double tolerance);
+EXTERN_MSC long GMT_shore_cache_size (long bytes);
+EXTERN_MSC void GMT_shore_cache_stats (long stats[4]);
+EXTERN_MSC void GMT_shore_cache_flush (void);
+EXTERN_MSC int GMT_shore_convert (char kind, char res, char *file);
+EXTERN_MSC int GMT_shore_index (char kind, char res, char *file);
+EXTERN_MSC int GMT_shore_rank (char kind, char res, char *file);
+EXTERN_MSC int GMT_shore_min_rank (unsigned char *rank, double scale, double tolerance);
+EXTERN_MSC void GMT_shore_lines_only (struct GMT_SHORE *c);
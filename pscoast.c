@@ -50,42 +50,451 @@
 int debug_bin = -1;
 #endif
 
-struct GMT_SHORE c;
-struct GMT_BR b, r;
+struct PSCOAST_CTX {	/* Everything one extraction works on.  Threads running pscoast at
+			 * the same time must each pass their own context */
+	struct GMT_SHORE c;	/* Shoreline reader */
+	struct GMT_BR b, r;	/* Border and river readers */
+	double w, e, s, n;	/* Region of the current request */
+	BOOLEAN world_map;	/* TRUE if the region wraps around in longitude */
+	BOOLEAN coast, river, border;	/* Layers of the current request */
+	BOOLEAN project;	/* TRUE if the lines go out projected, see pscoast_xy */
+	char *jarg;		/* and the map they go on, set up again for every bin */
+	double map_w, map_e, map_s, map_n;
+	BOOLEAN rect;
+	double pixels;		/* Lines are simplified to this many pixels, see pscoast_simplify */
+	int width;		/* on a map this many pixels wide */
+	BOOLEAN measure;	/* TRUE if pixels are measured on the map set up by pscoast_project */
+	double map_km;		/* Width of that map in km, see pscoast_map_size */
+	double map_m_pr_deg;	/* and its meters per degree */
+	long n_in, n_kept;	/* Points before and after simplifying, in the last extraction */
+};
+
+struct PSCOAST_BIN {	/* Where the lines of one bin go in the output */
+	int n;			/* Number of values, including a NaN before each line */
+	size_t start;		/* Offset of the first value in the output */
+	double *x, *y;		/* Projected lines, kept from counting to filling */
+	struct POL *p;		/* Polygons or pieces of the bin, kept for pscoast_polygons */
+	int np;
+	int n_in, n_kept;	/* Points before and after simplifying */
+};
+
+struct PSCOAST_JOB {	/* One layer (shorelines, rivers or borders) of an extraction */
+	struct PSCOAST_CTX *C;
+	char kind;		/* 'c', 'r' or 'b' */
+	int nb;			/* Number of bins in the layer */
+	int *levels, n_levels;	/* River or border levels to extract */
+	int min_level, max_level;
+	int start_direction, stop_direction;	/* -1 (water) and/or 1 (land) for polygons */
+	double min_area, edge, west_border, east_border;
+	BOOLEAN shift;
+	BOOLEAN polygons;	/* TRUE if the shorelines are kept as polygons, see pscoast_polygons */
+	BOOLEAN merge;		/* TRUE if the pieces of all bins are joined into whole polygons */
+	BOOLEAN keep;		/* TRUE if the lines of every bin are kept in out->p, see pscoast_gather */
+	int next;		/* Next bin to hand out to a worker */
+	struct PSCOAST_BIN *out;	/* Size and position of every bin */
+	void *lon, *lat;	/* Output buffers, or NULL while counting */
+	BOOLEAN single;		/* TRUE if the output is float rather than double */
+	double separator;	/* Value written before each line */
+	BOOLEAN project;	/* TRUE if the lines are projected */
+	double tolerance;	/* Lines are simplified to this, in km if projected or measured, else degrees */
+	BOOLEAN measure;	/* TRUE if the tolerance is measured with pscoast_forward */
+	BOOLEAN hold;		/* TRUE if bins are done while counting and held in out->x/y */
+#ifdef GMT_THREADS
+	pthread_mutex_t lock;	/* Guards next */
+#endif
+};
+
+struct PSCOAST_GRID {	/* A grid of x/y to inverse project, a row at a time */
+	double x0, dx, y0, dy;	/* First node and spacing, in km */
+	int nx, ny;
+	int next;		/* Next row to hand out to a worker */
+	int n_bad;		/* Nodes that did not converge */
+	double *lon, *lat;	/* Output, ny rows of nx */
+	char *ok;		/* Convergence mask, or NULL */
+#ifdef GMT_THREADS
+	pthread_mutex_t lock;	/* Guards next and n_bad */
+#endif
+};
+
+struct PSCOAST_ITER {	/* An extraction handed out a few bins at a time */
+	struct PSCOAST_CTX C;
+	struct PSCOAST_JOB J[3];
+	int rlevels[N_RLEVELS], blevels[N_BLEVELS];
+	int layer, ind;		/* Next bin to extract */
+	struct GMT_ARENA A;	/* Scratch for the polygons of one bin */
+};
+
+struct PSCOAST_CTX pscoast_default_ctx;	/* Used when the caller passes no context */
+BOOLEAN pscoast_initialized = FALSE;
+int pscoast_ellipsoid = -1;	/* gmtdefs.ellipsoid before GMT_set_spherical changed it */
+long pscoast_arena_stats[3] = {0, 0, 0};	/* Pieces, blocks and resets of all arenas so far */
 
 char *shore_resolution[5] = {"full", "high", "intermediate", "low", "crude"};
 
-void pscoast (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, SV *lon, SV *lat)
+void pscoast_init (void);
+void pscoast_into (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, SV *lon, SV *lat, BOOLEAN single, double separator, void *ctx, int n_threads);
+void pscoast_begin (struct PSCOAST_CTX *C, struct PSCOAST_JOB J[3], double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, BOOLEAN single, double separator, int paint);
+void pscoast_end (struct PSCOAST_CTX *C);
+void *pscoast_iter_new (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, BOOLEAN single, double separator);
+int pscoast_iter_next (void *iter, int max_values, SV *lon, SV *lat);
+void pscoast_iter_free (void *iter);
+void *pscoast_reader (struct PSCOAST_JOB *J);
+void *pscoast_context_new (void);
+void pscoast_context_free (void *ctx);
+size_t pscoast_count (struct PSCOAST_JOB *J, size_t start, int n_threads);
+void pscoast_fill (struct PSCOAST_JOB *J, void *lon, void *lat, int n_threads);
+void pscoast_run (struct PSCOAST_JOB *J, int n_threads);
+void pscoast_bin (struct PSCOAST_JOB *J, void *reader, int ind, struct GMT_ARENA *A);
+void pscoast_keep_bin (struct PSCOAST_JOB *J, void *reader, struct PSCOAST_BIN *out, struct GMT_ARENA *A);
+struct POL *pscoast_gather (struct PSCOAST_JOB *J, int n_threads, int *n);
+int pscoast_polygons (double west, double east, double south, double north, char res, int paint, BOOLEAN merge, SV *lon, SV *lat, SV *level, SV *interior, BOOLEAN single, double separator, void *ctx, int n_threads);
+int pscoast_stitch (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, SV *lon, SV *lat, BOOLEAN single, double separator, void *ctx, int n_threads, int *n_pieces);
+int pscoast_stitch_layer (struct PSCOAST_JOB *J, int n_threads, struct POL **line, double **xy, struct GMT_BIN_CACHE **cache, int *n_pieces);
+int pscoast_open (struct POL *p);
+size_t pscoast_put_ring (void *lon, void *lat, size_t n, struct POL *p, BOOLEAN close, BOOLEAN single, double separator);
+void pscoast_arena_done (struct GMT_ARENA *A);
+void pscoast_arena_stats_get (long stats[3]);
+int pscoast_project (char *jarg, double west, double east, double south, double north, BOOLEAN rect);
+void pscoast_project_lock (void);
+void pscoast_project_unlock (void);
+void pscoast_map_size (struct PSCOAST_CTX *C);
+int pscoast_xy (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, char *jarg, double map_w, double map_e, double map_s, double map_n, BOOLEAN rect, SV *x, SV *y, BOOLEAN single, double separator, void *ctx);
+void pscoast_project_bin (struct PSCOAST_JOB *J, struct PSCOAST_BIN *out, struct POL *p, int np);
+void pscoast_simplify_bin (struct PSCOAST_JOB *J, struct PSCOAST_BIN *out, struct POL *p, int np);
+int pscoast_thin (struct PSCOAST_BIN *out, double *x, double *y, int n, double tolerance, double *u, double *v);
+void pscoast_simplify (void *ctx, double pixels, int width, BOOLEAN measure);
+void pscoast_simplify_stats (void *ctx, long stats[2]);
+void pscoast_put_xy (struct PSCOAST_JOB *J, struct PSCOAST_BIN *out);
+void pscoast_forward (double lon, double lat, double *x, double *y);
+void pscoast_inverse (double x, double y, double *lon, double *lat);
+void pscoast_forward_array (SV *lon, SV *lat, SV *x, SV *y);
+void pscoast_inverse_array (SV *x, SV *y, SV *lon, SV *lat);
+int pscoast_fast_trig (int on);
+void pscoast_lat_swap (SV *lat, int itype, BOOLEAN table);
+int pscoast_inverse_grid (double x0, double dx, int nx, double y0, double dy, int ny, SV *lon, SV *lat, SV *ok, int n_threads);
+int pscoast_inverse_row (struct PSCOAST_GRID *G, int j, double *x, double *y);
+#ifdef GMT_THREADS
+void *pscoast_worker (void *arg);
+void *pscoast_grid_worker (void *arg);
+#endif
+
+void pscoast (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, SV *lon, SV *lat, void *ctx, int n_threads)
 {
-	int i, n, np, ind, bin, anti_bin = -1, level, flag;
-	int level_to_be_painted, max_level = MAX_LEVEL, direction, np_new, k, last_k;
-	int n_blevels = 0, n_rlevels = 0, bin_trouble;
-	int start_direction, stop_direction, lowest_level = 1, min_level = 0, n_pieces = 0;
+	/* Double precision output with NaN between lines */
 	
-	BOOLEAN	error = FALSE, set_lake_fill = FALSE, draw_river = FALSE, shift = FALSE, need_coast_base, recursive;
-	BOOLEAN	fill_ocean = FALSE, fill_land = FALSE, possibly_donut_hell = FALSE;
-	BOOLEAN clobber_background, draw_border = FALSE, paint_polygons = FALSE, donut, fill_in_use = FALSE;
-	BOOLEAN draw_scale = FALSE, gave_xy = FALSE, fancy = FALSE, donut_hell = FALSE, world_map_save;
-	BOOLEAN clip_ocean = FALSE, clip_land = FALSE, end_of_clip = FALSE, clipping = FALSE;
+	pscoast_init ();
+	pscoast_into (west, east, south, north, res, rlevels, blevels, draw_coast, lon, lat, FALSE, GMT_d_NaN, ctx, n_threads);
+}
+
+void pscoast_into (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, SV *lon, SV *lat, BOOLEAN single, double separator, void *ctx, int n_threads)
+{
+	/* Writes the lines as float (single = TRUE) or double values into lon and
+	 * lat, which are typically the data of two piddles.  separator goes before
+	 * each line, so the caller need not replace NaNs afterwards */
+	 
+	dTHX;
+	int i;
+	size_t n_out, esize;
+	struct PSCOAST_JOB J[3];
+	struct PSCOAST_CTX *C;
+
+	C = (ctx) ? (struct PSCOAST_CTX *)ctx : &pscoast_default_ctx;
+	
+	pscoast_begin (C, J, west, east, south, north, res, rlevels, blevels, draw_coast, single, separator, 0);
+	
+	/* First pass finds how many values every bin gives, so the output can be
+	 * allocated once at its final size.  The second pass copies the lines of
+	 * each bin straight into place */
 	
-	double	bin_x[5], bin_y[5];
-	double west_border, east_border, anti_lon, anti_lat, edge = 720.0, left, right;
-	double *xtmp, *ytmp, min_area = 0.0, x0, y0, scale_lat, length, step = 0.01;
-	double anti_x, anti_y, x_0, y_0, x_c, y_c, dist, out[2], mylon;
+	for (i = 0, n_out = 0; i < 3; i++) n_out = pscoast_count (&J[i], n_out, n_threads);
+	
+	esize = (single) ? sizeof (float) : sizeof (double);
+	sv_setpvn (lon, "", 0);	/* lon and lat are replaced, e.g. the data of a piddle */
+	sv_setpvn (lat, "", 0);
+	SvGROW (lon, n_out * esize + 1);
+	SvGROW (lat, n_out * esize + 1);
+	
+	for (i = 0; i < 3; i++) {
+		if (i == 1 && J[i].nb && gmtdefs.verbose) fprintf (stderr, "%s: Adding Rivers...", GMT_program);
+		if (i == 2 && J[i].nb && gmtdefs.verbose) fprintf (stderr, "%s: Adding Borders...", GMT_program);
+		pscoast_fill (&J[i], (void *)SvPVX (lon), (void *)SvPVX (lat), n_threads);
+		if (gmtdefs.verbose && (i == 0 || J[i].nb)) fprintf (stderr, "\n");
+	}
+	SvCUR_set (lon, n_out * esize);
+	SvCUR_set (lat, n_out * esize);
 	
-        char *myptr;
-        int len, base, latlonlen = 0;
+	pscoast_end (C);
+}
+
+int pscoast_polygons (double west, double east, double south, double north, char res, int paint, BOOLEAN merge, SV *lon, SV *lat, SV *level, SV *interior, BOOLEAN single, double separator, void *ctx, int n_threads)
+{
+	/* Closed shoreline polygons instead of lines.  paint is 1 for land, 2 for
+	 * water and 3 for both, like GMT's -G and -S.  With merge the pieces of
+	 * all bins are joined into one ring per polygon (GMT_merge_shore), else
+	 * every bin gives its own polygons (GMT_assemble_shore).  The rings go
+	 * into lon/lat like lines, closed and preceded by the separator, and
+	 * their levels (int) and whether they are whole shorelines (char) into
+	 * level and interior.  Returns the number of rings */
+
+	dTHX;
+	int i, ind, np, n_all, corner_level, dir, rlevels[N_RLEVELS], blevels[N_BLEVELS];
+	int *plevel;
+	size_t n, n_out, esize;
+	double d;
+	char *pinterior;
+	struct POL *all, *p;
+	struct GMT_SHORE *c;
+	struct GMT_SHORE_OUTLINE B;
+	struct PSCOAST_JOB J[3];
+	struct PSCOAST_CTX *C;
+
+	C = (ctx) ? (struct PSCOAST_CTX *)ctx : &pscoast_default_ctx;
+	c = &C->c;
+	memset ((void *)rlevels, 0, N_RLEVELS * sizeof (int));
+	memset ((void *)blevels, 0, N_BLEVELS * sizeof (int));
+
+	pscoast_begin (C, J, west, east, south, north, res, rlevels, blevels, TRUE, single, separator, paint);
+	J[0].merge = merge;
+	c->straight = TRUE;	/* Bin edges are straight in lon/lat, whatever projection was set up last */
+
+	all = pscoast_gather (&J[0], n_threads, &n_all);
+
+	if (merge && J[0].nb) {	/* The bins tile B, the region rounded out to whole bins */
+		B.w = J[0].west_border;
+		B.e = J[0].east_border;
+		B.s = 90.0 - ceil ((90.0 - C->s) / c->bsize) * c->bsize;
+		B.n = 90.0 - floor ((90.0 - C->n) / c->bsize) * c->bsize;
+		B.width = B.e - B.w;
+		B.height = B.n - B.s;
+		B.perimeter = 2.0 * (B.width + B.height);
+		B.step = c->bsize;
+		B.tol = 0.5 * c->scale;
+
+		for (ind = corner_level = 0; ind < c->nb; ind++) {	/* SW node of the SW bin */
+			d = fmod ((c->bins[ind] % c->bin_nx) * c->bsize - B.w + 720.0, 360.0);
+			if ((d > SMALL && d < 360.0 - SMALL) || fabs (90.0 - (c->bins[ind] / c->bin_nx + 1) * c->bsize - B.s) > SMALL) continue;
+			corner_level = MIN (((unsigned short)c->bin_info[ind] >> 9) & 7, J[0].max_level);
+		}
+
+		dir = (paint == 3) ? 0 : ((paint == 1) ? 1 : -1);
+		np = GMT_merge_shore (all, n_all, dir, J[0].min_level, corner_level, &B, &p);
+		GMT_free_polygons (all, n_all);
+		if (all) GMT_free ((void *)all);
+	}
+	else {
+		p = all;
+		np = n_all;
+	}
+
+	for (i = 0, n_out = 0; i < np; i++) n_out += p[i].n + 1 + pscoast_open (&p[i]);
+
+	esize = (single) ? sizeof (float) : sizeof (double);
+	sv_setpvn (lon, "", 0);
+	sv_setpvn (lat, "", 0);
+	sv_setpvn (level, "", 0);
+	sv_setpvn (interior, "", 0);
+	SvGROW (lon, n_out * esize + 1);
+	SvGROW (lat, n_out * esize + 1);
+	SvGROW (level, np * sizeof (int) + 1);
+	SvGROW (interior, np + 1);
+	plevel = (int *)SvPVX (level);
+	pinterior = (char *)SvPVX (interior);
+
+	for (i = 0, n = 0; i < np; i++) {
+		n = pscoast_put_ring ((void *)SvPVX (lon), (void *)SvPVX (lat), n, &p[i], TRUE, single, separator);
+		plevel[i] = p[i].level;
+		pinterior[i] = (char)p[i].interior;
+	}
+	SvCUR_set (lon, n_out * esize);
+	SvCUR_set (lat, n_out * esize);
+	SvCUR_set (level, np * sizeof (int));
+	SvCUR_set (interior, np);
+
+	GMT_free_polygons (p, np);
+	if (p) GMT_free ((void *)p);
+	pscoast_end (C);
+
+	return (np);
+}
+
+int pscoast_stitch (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, SV *lon, SV *lat, BOOLEAN single, double separator, void *ctx, int n_threads, int *n_pieces)
+{
+	/* Like pscoast_into, but lines that go on from bin to bin come out whole
+	 * (GMT_stitch_lines) instead of cut at every bin edge.  The stitched
+	 * lines of each layer are cached alongside the bins.  Sets n_pieces to
+	 * the number of lines before stitching and returns the number after */
+
+	dTHX;
+	int i, k, n_lines = 0, n_line[3];
+	size_t n, n_out, esize;
+	double *xy[3];
+	struct POL *line[3];
+	struct GMT_BIN_CACHE *cache[3];
+	struct PSCOAST_JOB J[3];
+	struct PSCOAST_CTX *C;
+
+	C = (ctx) ? (struct PSCOAST_CTX *)ctx : &pscoast_default_ctx;
+
+	pscoast_begin (C, J, west, east, south, north, res, rlevels, blevels, draw_coast, single, separator, 0);
+
+	*n_pieces = 0;
+	for (i = 0, n_out = 0; i < 3; i++) {
+		n_line[i] = pscoast_stitch_layer (&J[i], n_threads, &line[i], &xy[i], &cache[i], n_pieces);
+		for (k = 0; k < n_line[i]; k++) n_out += line[i][k].n + 1;
+		n_lines += n_line[i];
+	}
 
-	char key[5], *string, measure = '\0', comment[32];
+	esize = (single) ? sizeof (float) : sizeof (double);
+	sv_setpvn (lon, "", 0);
+	sv_setpvn (lat, "", 0);
+	SvGROW (lon, n_out * esize + 1);
+	SvGROW (lat, n_out * esize + 1);
 
+	for (i = 0, n = 0; i < 3; i++) {
+		for (k = 0; k < n_line[i]; k++) n = pscoast_put_ring ((void *)SvPVX (lon), (void *)SvPVX (lat), n, &line[i][k], FALSE, single, separator);
+		if (cache[i])
+			GMT_stitch_cache_release (cache[i]);
+		else if (line[i]) {
+			GMT_free ((void *)line[i]);
+			GMT_free ((void *)xy[i]);
+		}
+	}
+	SvCUR_set (lon, n_out * esize);
+	SvCUR_set (lat, n_out * esize);
+
+	pscoast_end (C);
+
+	return (n_lines);
+}
+
+int pscoast_stitch_layer (struct PSCOAST_JOB *J, int n_threads, struct POL **line, double **xy, struct GMT_BIN_CACHE **cache, int *n_pieces)
+{
+	/* Gives the stitched lines of one layer, from the cache if it has them.
+	 * They are keyed on the bins the region covers and the levels selected */
+
+	int k, n, np, filter[3];
+	char res;
+	double box[4];
 	struct POL *p;
+	struct GMT_SHORE_OUTLINE B;
+	struct GMT_BR *br;
+
+	*line = (struct POL *)NULL;
+	*xy = (double *)NULL;
+	*cache = (struct GMT_BIN_CACHE *)NULL;
+	if (J->nb == 0) return (0);
+
+	memset ((void *)&B, 0, sizeof (struct GMT_SHORE_OUTLINE));
+	if (J->kind == 'c') {
+		res = J->C->c.res;
+		B.step = J->C->c.bsize;
+		B.tol = 0.5 * J->C->c.scale;
+		filter[0] = irint (10.0 * J->min_area);	/* As GMT_get_shore_bin selects */
+		filter[1] = J->min_level + (GMT_shore_min_rank (J->C->c.rank, J->C->c.scale, J->C->c.tolerance) << 8);
+		filter[2] = J->max_level;
+	}
+	else {
+		br = (J->kind == 'r') ? &J->C->r : &J->C->b;
+		res = br->res;
+		B.step = br->bsize;
+		B.tol = 0.5 * br->scale;
+		for (k = 0, filter[0] = (J->n_levels == 0) ? -1 : 0; k < J->n_levels; k++) if (J->levels[k] >= 0 && J->levels[k] < 31) filter[0] |= (1 << J->levels[k]);
+		filter[1] = GMT_shore_min_rank (br->rank, br->scale, br->tolerance) << 8;
+		filter[2] = 0;
+	}
+	box[0] = B.w = J->west_border;
+	box[1] = B.e = J->east_border;
+	box[2] = B.s = 90.0 - ceil ((90.0 - J->C->s) / B.step) * B.step;
+	box[3] = B.n = 90.0 - floor ((90.0 - J->C->n) / B.step) * B.step;
+
+	if ((*cache = GMT_stitch_cache_find (J->kind, res, filter, box))) {
+		*line = (struct POL *)(*cache)->seg;
+		*xy = (*cache)->xy;
+		*n_pieces += (*cache)->n_pieces;
+		return ((*cache)->ns);
+	}
+
+	J->keep = TRUE;
+	p = pscoast_gather (J, n_threads, &np);
+	n = GMT_stitch_lines (p, np, &B, line, xy);
+	GMT_free_polygons (p, np);
+	if (p) GMT_free ((void *)p);
+
+	*n_pieces += np;
+	*cache = GMT_stitch_cache_add (J->kind, res, filter, box, n, *line, *xy, np);
+	return (n);
+}
+
+int pscoast_open (struct POL *p)
+{
+	/* 1 if the last point of p is not its first, so the ring needs one more */
+
+	return (p->n > 0 && (p->lon[p->n-1] != p->lon[0] || p->lat[p->n-1] != p->lat[0]));
+}
+
+size_t pscoast_put_ring (void *lon, void *lat, size_t n, struct POL *p, BOOLEAN close, BOOLEAN single, double separator)
+{
+	/* Writes the separator and then ring p, closed if need be, from value n on.
+	 * Returns where the next goes */
+
+	int k, m;
+	float *flon, *flat;
+	double *dlon, *dlat;
+
+	m = p->n + ((close) ? pscoast_open (p) : 0);
+	if (single) {
+		flon = (float *)lon + n;
+		flat = (float *)lat + n;
+		flon[0] = flat[0] = (float)separator;
+		for (k = 0; k < m; k++) {
+			flon[k+1] = (float)p->lon[k % p->n];
+			flat[k+1] = (float)p->lat[k % p->n];
+		}
+	}
+	else {
+		dlon = (double *)lon + n;
+		dlat = (double *)lat + n;
+		dlon[0] = dlat[0] = separator;
+		memcpy ((void *)&dlon[1], (void *)p->lon, (size_t)p->n * sizeof (double));
+		memcpy ((void *)&dlat[1], (void *)p->lat, (size_t)p->n * sizeof (double));
+		if (m > p->n) {
+			dlon[m] = p->lon[0];
+			dlat[m] = p->lat[0];
+		}
+	}
+	return (n + m + 1);
+}
+
+void pscoast_begin (struct PSCOAST_CTX *C, struct PSCOAST_JOB J[3], double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, BOOLEAN single, double separator, int paint)
+{
+	/* Opens the readers for the region in C and sets up one job per layer.
+	 * paint is 0 for lines, else 1 to fill land, 2 to fill water or 3 for both */
+	 
+	int i, base, max_level = MAX_LEVEL, min_level = 0;
+	int n_blevels = 0, n_rlevels = 0, start_direction, stop_direction;
+	
+	BOOLEAN	draw_river = FALSE, draw_border = FALSE, shift = FALSE, need_coast_base;
+	BOOLEAN	fill_ocean = FALSE, fill_land = FALSE, paint_polygons = FALSE, end_of_clip = FALSE;
+	
+	double west_border, east_border, edge = 720.0, min_area = 0.0, tolerance = 0.0, rank_tolerance;
+
+	struct GMT_SHORE *c;
+	struct GMT_BR *b, *r;
+
+	c = &C->c;
+	b = &C->b;
+	r = &C->r;
+
+	fill_land = (paint & 1);
+	fill_ocean = (paint & 2);
+	paint_polygons = (fill_land || fill_ocean);
 
 	for (i=0;i<N_BLEVELS;i++) if (blevels[i]) n_blevels++;
 	for (i=0;i<N_RLEVELS;i++) if (rlevels[i]) n_rlevels++;
 	if (n_rlevels) draw_river  = TRUE;
 	if (n_blevels) draw_border = TRUE;
 
-	my_GMT_begin (); 
+	pscoast_init (); 
 
 	base = GMT_set_resolution (&res, 'D');
 
@@ -96,23 +505,33 @@ void pscoast (double west, double east, double south, double north, char res, in
 		east -= 360.0;
 	}
 	
-	GMT_map_getproject ("x1d");
-
-	GMT_map_setup (west, east, south, north);
-
-	world_map_save = GMT_world_map;
+	/* Same region as GMT_map_setup gives for -Jx1d, but kept in the context
+	 * so that the global map projection is left alone */
+	
+	if (west == east && south == north) {
+		fprintf (stderr, "%s: GMT Fatal Error: No region selected - Aborts!\n", GMT_program);
+		exit (EXIT_FAILURE);
+	}
+	if (east < west) east += 360.0;
+	if ((fabs (east - west) - 360.0) > SMALL) {
+		fprintf (stderr, "%s: GMT Fatal Error: Region exceeds 360 degrees!\n", GMT_program);
+		exit (EXIT_FAILURE);
+	}
+	C->w = west;	C->e = east;	C->s = south;	C->n = north;
+	C->world_map = (fabs (fabs (C->e - C->w) - 360.0) < SMALL);
 	
-	if (need_coast_base && GMT_init_shore (res, &c, project_info.w, project_info.e, project_info.s, project_info.n))  {
+	if (need_coast_base && GMT_init_shore (res, c, C->w, C->e, C->s, C->n))  {
 		fprintf (stderr, "%s: %s resolution shoreline data base not installed\n", GMT_program, shore_resolution[base]);
 		need_coast_base = FALSE;
 	}
+	if (need_coast_base && !paint_polygons) GMT_shore_lines_only (c);	/* Empty bins only matter to polygons */
 	
-	if (draw_border && GMT_init_br ('b', res, &b, project_info.w, project_info.e, project_info.s, project_info.n)) {
+	if (draw_border && GMT_init_br ('b', res, b, C->w, C->e, C->s, C->n)) {
 		fprintf (stderr, "%s: %s resolution political boundary data base not installed\n", GMT_program, shore_resolution[base]);
 		draw_border = FALSE;
 	}
 	
-	if (draw_river && GMT_init_br ('r', res, &r, project_info.w, project_info.e, project_info.s, project_info.n)) {
+	if (draw_river && GMT_init_br ('r', res, r, C->w, C->e, C->s, C->n)) {
 		fprintf (stderr, "%s: %s resolution river data base not installed\n", GMT_program, shore_resolution[base]);
 		draw_river = FALSE;
 	}
@@ -122,12 +541,12 @@ void pscoast (double west, double east, double south, double north, char res, in
 		exit (EXIT_FAILURE);
 	}
 
-	start_direction = -1;
-	stop_direction = 1;
-	lowest_level = (fill_ocean) ? 0 : 1;
+	start_direction = (fill_ocean) ? -1 : 1;
+	stop_direction = (fill_land) ? 1 : -1;
 
-	if ((360.0 - fabs (project_info.e - project_info.w) ) < c.bsize)
-		GMT_world_map = TRUE;
+	if ((360.0 - fabs (C->e - C->w) ) < c->bsize)
+		C->world_map = TRUE;
+	c->world_map = C->world_map;
 	
 	/* west_border = project_info.w;	east_border = project_info.e; */
 
@@ -142,146 +561,963 @@ void pscoast (double west, double east, double south, double north, char res, in
 	*/
 
 	/* west_border = project_info.w;	east_border = project_info.e; */
-	west_border = floor (project_info.w / c.bsize) * c.bsize;
-	east_border = ceil (project_info.e / c.bsize) * c.bsize;
-		
-	for (ind = 0; need_coast_base && ind < c.nb; ind++) {	/* Loop over necessary bins only */
-		
-		bin = c.bins[ind];
-#ifdef DEBUG
-		if (debug_bin >= 0 && bin != debug_bin) continue;
-#endif
-		GMT_get_shore_bin (ind, &c, min_area, min_level, max_level);
-		
-		if (gmtdefs.verbose) fprintf (stderr, "%s: Working on block # %5d\r", GMT_program, bin);
+	west_border = floor (C->w / c->bsize) * c->bsize;
+	east_border = ceil (C->e / c->bsize) * c->bsize;
+
+	if (C->pixels > 0.0 && C->width > 0) {	/* Pixels to km on the map, or to degrees of the region */
+		if (C->project || C->measure)
+			tolerance = C->pixels * C->map_km / C->width;
+		else
+			tolerance = C->pixels * (C->e - C->w) / C->width;
+	}
+	
+	/* Databases with point ranks skip what cannot show while the bins are read */
+	
+	rank_tolerance = (C->project || C->measure) ? ((C->map_m_pr_deg > 0.0) ? tolerance * 1000.0 / C->map_m_pr_deg : 0.0) : tolerance;
+	if (need_coast_base) c->tolerance = rank_tolerance;
+	if (draw_river) r->tolerance = rank_tolerance;
+	if (draw_border) b->tolerance = rank_tolerance;
+	C->n_in = C->n_kept = 0;
+	
+	memset ((void *)J, 0, 3 * sizeof (struct PSCOAST_JOB));
+	for (i = 0; i < 3; i++) {
+		J[i].C = C;
+		J[i].min_area = min_area;
+		J[i].min_level = min_level;
+		J[i].max_level = max_level;
+		J[i].start_direction = start_direction;
+		J[i].stop_direction = stop_direction;
+		J[i].polygons = paint_polygons;
+		J[i].keep = paint_polygons;
+		J[i].shift = shift;
+		J[i].edge = edge;
+		J[i].west_border = west_border;
+		J[i].east_border = east_border;
+		J[i].single = single;
+		J[i].separator = separator;
+		J[i].project = C->project;
+		J[i].tolerance = tolerance;
+		J[i].measure = C->measure && !C->project;
+		J[i].hold = (C->project || tolerance > 0.0);
+	}
+	J[0].kind = 'c';	J[0].nb = (need_coast_base) ? c->nb : 0;
+	J[1].kind = 'r';	J[1].nb = (draw_river) ? r->nb : 0;
+	J[1].levels = rlevels;	J[1].n_levels = n_rlevels;
+	J[2].kind = 'b';	J[2].nb = (draw_border) ? b->nb : 0;
+	J[2].levels = blevels;	J[2].n_levels = n_blevels;
+	
+	C->coast = need_coast_base;
+	C->river = draw_river;
+	C->border = draw_border;
+}
 
-		bin_trouble = (anti_bin == bin) ? anti_bin : -1;
-			
-		if (draw_coast && c.ns) {	/* Draw or dump shorelines, no need to assemble polygons */
-			/* if ((np = GMT_assemble_shore (&c, direction, FALSE, shift, edge, &p)) == 0) continue; */
-			if ((np = GMT_assemble_shore (&c, direction, min_level, FALSE, shift, west_border, east_border, &p)) == 0) continue;
+void pscoast_end (struct PSCOAST_CTX *C)
+{
+	/* Releases what pscoast_begin set up */
+	
+	if (C->coast) GMT_shore_cleanup (&C->c);
+	if (C->river) GMT_br_cleanup (&C->r);
+	if (C->border) GMT_br_cleanup (&C->b);
+	C->coast = C->river = C->border = FALSE;
+}
 
-			for (i = 0; i < np; i++) {
-			  latlonlen += (p[i].n + 2)*sizeof(double);
-			}
-			SvGROW(lon, latlonlen);  /* pregrow for efficiency */
-			SvGROW(lat, latlonlen);  /* pregrow for efficiency */
-
-			for (i = 0; i < np; i++) {
-			  sv_catpvn(lon, (char *) &GMT_d_NaN, sizeof(double)); /* separator */
-			  sv_catpvn(lat, (char *) &GMT_d_NaN, sizeof(double)); /* separator */
-			  for (k = 0; k < p[i].n; k++) {
-                            mylon = p[i].lon[k];
-			    sv_catpvn(lon, (char *) &(mylon), sizeof(double)); 
-			    sv_catpvn(lat, (char *) &(p[i].lat[k]), sizeof(double)); 
-			  }
-			}
-			
-			GMT_free_polygons (p, np);
-			GMT_free ((void *)p);
+void *pscoast_iter_new (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, BOOLEAN single, double separator)
+{
+	/* Starts an extraction that pscoast_iter_next hands out in pieces.  The
+	 * readers stay open, in a context of their own, until pscoast_iter_free */
+	
+	int i;
+	struct PSCOAST_ITER *I;
+	
+	pscoast_init ();
+	I = (struct PSCOAST_ITER *) GMT_memory (VNULL, (size_t)1, sizeof (struct PSCOAST_ITER), "pscoast_iter_new");
+	memcpy ((void *)I->rlevels, (void *)rlevels, N_RLEVELS * sizeof (int));
+	memcpy ((void *)I->blevels, (void *)blevels, N_BLEVELS * sizeof (int));
+	
+	pscoast_begin (&I->C, I->J, west, east, south, north, res, I->rlevels, I->blevels, draw_coast, single, separator, 0);
+	
+	for (i = 0; i < 3; i++) {
+		if (I->J[i].nb == 0) continue;
+		I->J[i].out = (struct PSCOAST_BIN *) GMT_memory (VNULL, (size_t)I->J[i].nb, sizeof (struct PSCOAST_BIN), "pscoast_iter_new");
+	}
+	return ((void *)I);
+}
+
+int pscoast_iter_next (void *iter, int max_values, SV *lon, SV *lat)
+{
+	/* Replaces lon/lat with the next whole bins, as many as fit in max_values
+	 * (but at least one bin).  Returns the number of values, 0 when done */
+	
+	dTHX;
+	int layer, ind, n;
+	size_t n_out, esize;
+	struct PSCOAST_ITER *I;
+	struct PSCOAST_JOB *J;
+	
+	I = (struct PSCOAST_ITER *)iter;
+	layer = I->layer;
+	ind = I->ind;
+	
+	for (n_out = 0; I->layer < 3; I->ind++) {	/* Count the bins that fit */
+		J = &I->J[I->layer];
+		if (I->ind >= J->nb) {
+			I->layer++;
+			I->ind = -1;
+			continue;
 		}
-		
-		GMT_free_shore (&c);
+		J->lon = J->lat = VNULL;
+		pscoast_bin (J, pscoast_reader (J), I->ind, &I->A);
+		n = J->out[I->ind].n;
+		if (n_out > 0 && max_values > 0 && n_out + n > (size_t)max_values) break;
+		J->out[I->ind].start = n_out;
+		n_out += n;
+	}
+	if (I->layer == 3) I->ind = 0;
+	
+	esize = (I->J[0].single) ? sizeof (float) : sizeof (double);
+	sv_setpvn (lon, "", 0);
+	sv_setpvn (lat, "", 0);
+	SvGROW (lon, n_out * esize + 1);
+	SvGROW (lat, n_out * esize + 1);
 	
+	for (; layer < I->layer || (layer == I->layer && ind < I->ind); ind++) {	/* Copy them */
+		J = &I->J[layer];
+		if (ind >= J->nb) {
+			layer++;
+			ind = -1;
+			continue;
+		}
+		if (J->out[ind].n == 0) continue;
+		J->lon = (void *)SvPVX (lon);
+		J->lat = (void *)SvPVX (lat);
+		pscoast_bin (J, pscoast_reader (J), ind, &I->A);
 	}
+	SvCUR_set (lon, n_out * esize);
+	SvCUR_set (lat, n_out * esize);
+	
+	return ((int)n_out);
+}
 
-	if (need_coast_base) GMT_shore_cleanup (&c);
+void pscoast_iter_free (void *iter)
+{
+	int i;
+	struct PSCOAST_ITER *I;
+	
+	if (!iter) return;
+	I = (struct PSCOAST_ITER *)iter;
+	for (i = 0; i < 3; i++) if (I->J[i].out) GMT_free ((void *)I->J[i].out);
+	pscoast_arena_done (&I->A);
+	pscoast_end (&I->C);
+	GMT_free (iter);
+}
 
-	if (gmtdefs.verbose) fprintf (stderr, "\n");
+void *pscoast_reader (struct PSCOAST_JOB *J)
+{
+	/* The reader a job's bins come from */
 	
-	if (draw_river) {	/* Read rivers file and plot as lines */
-		
-		if (gmtdefs.verbose) fprintf (stderr, "%s: Adding Rivers...", GMT_program);
-		last_k = -1;
+	if (J->kind == 'c') return ((void *)&J->C->c);
+	return ((void *)((J->kind == 'r') ? &J->C->r : &J->C->b));
+}
 
-		for (ind = 0; ind < r.nb; ind++) {	/* Loop over necessary bins only */
-		
-			bin = r.bins[ind];
-			GMT_get_br_bin (ind, &r, rlevels, n_rlevels);
-			
-			if (r.ns == 0) continue;
-			
-			if ((np = GMT_assemble_br (&r, shift, edge, &p)) == 0) continue;
-
-			for (i = 0; i < np; i++) {
-			  latlonlen += (p[i].n + 2)*sizeof(double);
-			}
-			SvGROW(lon, latlonlen);  /* pregrow for efficiency */
-			SvGROW(lat, latlonlen);  /* pregrow for efficiency */
-
-			for (i = 0; i < np; i++) {
-			  sv_catpvn(lon, (char *) &GMT_d_NaN, sizeof(double)); /* separator */
-			  sv_catpvn(lat, (char *) &GMT_d_NaN, sizeof(double)); /* separator */
-			  for (k = 0; k < p[i].n; k++) {
-                            mylon = p[i].lon[k];
-			    sv_catpvn(lon, (char *) &(mylon), sizeof(double)); 
-			    sv_catpvn(lat, (char *) &(p[i].lat[k]), sizeof(double)); 
-			  }
-			}
-			
-			/* Free up memory */
+size_t pscoast_count (struct PSCOAST_JOB *J, size_t start, int n_threads)
+{
+	/* Counts the values of all bins in the layer and lays them out one after
+	 * the other from start.  Returns the end of the layer */
+	
+	int ind;
+	
+	if (J->nb == 0) return (start);
+	J->out = (struct PSCOAST_BIN *) GMT_memory (VNULL, (size_t)J->nb, sizeof (struct PSCOAST_BIN), "pscoast_count");
+	J->lon = J->lat = VNULL;
+	pscoast_run (J, n_threads);
+	for (ind = 0; ind < J->nb; ind++) {
+		J->out[ind].start = start;
+		start += J->out[ind].n;
+		J->C->n_in += J->out[ind].n_in;
+		J->C->n_kept += J->out[ind].n_kept;
+	}
+	return (start);
+}
+
+void pscoast_fill (struct PSCOAST_JOB *J, void *lon, void *lat, int n_threads)
+{
+	/* Copies the lines of all bins in the layer to where pscoast_count put them */
+	
+	if (J->nb == 0) return;
+	J->lon = lon;
+	J->lat = lat;
+	pscoast_run (J, n_threads);
+	GMT_free ((void *)J->out);
+	J->out = (struct PSCOAST_BIN *)NULL;
+}
+
+void pscoast_run (struct PSCOAST_JOB *J, int n_threads)
+{
+	/* Runs pscoast_bin on all bins of one layer.  With several threads the bins
+	 * are handed out to a pool of workers.  Every bin has its own slot in the
+	 * output, so the result does not depend on which worker did what */
+	 
+	int ind;
+	struct GMT_ARENA A;
+#ifdef GMT_THREADS
+	int t;
+	pthread_t *thread;
+	
+	if (n_threads > J->nb) n_threads = J->nb;
+	if (n_threads > 1) {
+		J->next = 0;
+		thread = (pthread_t *) GMT_memory (VNULL, (size_t)n_threads, sizeof (pthread_t), "pscoast_run");
+		pthread_mutex_init (&J->lock, NULL);
 		
-			GMT_free_br (&r);
-			for (k = 0; k < np; k++) {
-				GMT_free ((void *)p[k].lon);
-				GMT_free ((void *)p[k].lat);
+		for (t = 0; t < n_threads; t++) {
+			if (pthread_create (&thread[t], NULL, pscoast_worker, (void *)J)) {
+				fprintf (stderr, "%s: Could not start worker thread\n", GMT_program);
+				break;
 			}
-			GMT_free ((void *)p);
 		}
-		GMT_br_cleanup (&r);
+		if (t == 0) pscoast_worker ((void *)J);	/* Do it ourselves then */
+		while (t > 0) pthread_join (thread[--t], NULL);
 		
-		if (gmtdefs.verbose) fprintf (stderr, "\n");
+		pthread_mutex_destroy (&J->lock);
+		GMT_free ((void *)thread);
+		return;
 	}
+#endif
+	memset ((void *)&A, 0, sizeof (struct GMT_ARENA));
+	for (ind = 0; ind < J->nb; ind++) pscoast_bin (J, pscoast_reader (J), ind, &A);	/* Loop over necessary bins only */
+	pscoast_arena_done (&A);
+}
+
+#ifdef GMT_THREADS
+void *pscoast_worker (void *arg)
+{
+	/* Takes bins off the job until none are left.  Each worker has its own
+	 * copy of the reader and its own arena so segments and scratch memory are private */
+	 
+	int ind;
+	struct PSCOAST_JOB *J;
+	struct GMT_SHORE c;
+	struct GMT_BR br;
+	struct GMT_ARENA A;
+	
+	J = (struct PSCOAST_JOB *)arg;
+	memset ((void *)&A, 0, sizeof (struct GMT_ARENA));
+	if (J->kind == 'c')
+		c = J->C->c;
+	else
+		br = (J->kind == 'r') ? J->C->r : J->C->b;
+	
+	for (;;) {
+		pthread_mutex_lock (&J->lock);
+		ind = J->next++;
+		pthread_mutex_unlock (&J->lock);
+		if (ind >= J->nb) break;
+		pscoast_bin (J, (J->kind == 'c') ? (void *)&c : (void *)&br, ind, &A);
+	}
+	pscoast_arena_done (&A);
+	return (NULL);
+}
+#endif
 
-	if (draw_border) {	/* Read borders file and plot as lines */
+void pscoast_bin (struct PSCOAST_JOB *J, void *reader, int ind, struct GMT_ARENA *A)
+{
+	/* Extracts bin ind.  While counting only the number of values is noted,
+	 * otherwise the lines are copied to the output, each one preceded by the separator.
+	 * The lines are assembled in A, which is reset for the next bin */
+	 
+	int i, k, n, np;
+	float *flon, *flat;
+	double *dlon, *dlat;
+	struct POL *p;
+	struct GMT_SHORE *c = NULL;
+	struct GMT_BR *br = NULL;
+	struct PSCOAST_BIN *out;
+	
+	out = &J->out[ind];
+	
+	if (J->hold && J->lon) {	/* Projected or simplified while counting */
+		pscoast_put_xy (J, out);
+		return;
+	}
+	
+	if (J->kind == 'c') {
+		c = (struct GMT_SHORE *)reader;
+#ifdef DEBUG
+		if (debug_bin >= 0 && c->bins[ind] != debug_bin) {
+			out->n = 0;
+			return;
+		}
+#endif
+		if (J->keep) {	/* Kept until all bins are done */
+			GMT_get_shore_bin (ind, c, J->min_area, J->min_level, J->max_level);
+			pscoast_keep_bin (J, (void *)c, out, A);
+			GMT_arena_reset (A);
+			GMT_free_shore (c);
+			return;
+		}
+		if (J->lon == NULL && !J->hold && c->bin_npt && J->min_area <= 0.0 && J->min_level <= 0 && J->max_level >= c->top_level) {
+			out->n = c->bin_npt[ind] + c->bin_nseg[ind];	/* Nothing filtered out, so the index knows */
+			return;
+		}
 		
-		if (gmtdefs.verbose) fprintf (stderr, "%s: Adding Borders...", GMT_program);
+		GMT_get_shore_bin (ind, c, J->min_area, J->min_level, J->max_level);
 		
-		/* Must resample borders because some points may be too far apart and look like 'jumps' */
+		if (J->lon == NULL && !J->hold) {
+			for (i = n = 0; i < c->ns; i++) n += c->seg[i].n + 1;
+			out->n = n;
+			GMT_free_shore (c);
+			return;
+		}
 		
-		step = MAX (fabs(project_info.w - project_info.e), fabs (project_info.n - project_info.s)) / 4.0;
-
-		last_k = -1;
-
-		for (ind = 0; ind < b.nb; ind++) {	/* Loop over necessary bins only */
+		if (gmtdefs.verbose) fprintf (stderr, "%s: Working on block # %5d\r", GMT_program, c->bins[ind]);
 		
-			bin = b.bins[ind];
-			GMT_get_br_bin (ind, &b, blevels, n_blevels);
-			
-			if (b.ns == 0) continue;
-			
-			if ((np = GMT_assemble_br (&b, shift, edge, &p)) == 0) continue;
-
-			for (i = 0; i < np; i++) {
-			  latlonlen += (p[i].n + 2)*sizeof(double);
-			}
-			SvGROW(lon, latlonlen);  /* pregrow for efficiency */
-			SvGROW(lat, latlonlen);  /* pregrow for efficiency */
-
-			for (i = 0; i < np; i++) {
-			  sv_catpvn(lon, (char *) &GMT_d_NaN, sizeof(double)); /* separator */
-			  sv_catpvn(lat, (char *) &GMT_d_NaN, sizeof(double)); /* separator */
-			  for (k = 0; k < p[i].n; k++) {
-                            mylon = p[i].lon[k];
-			    sv_catpvn(lon, (char *) &(mylon), sizeof(double)); 
-			    sv_catpvn(lat, (char *) &(p[i].lat[k]), sizeof(double)); 
-			  }
-			}
-			
-			/* Free up memory */
+		np = (c->ns) ? GMT_assemble_shore (c, J->start_direction, J->min_level, FALSE, J->shift, J->west_border, J->east_border, &p, A) : 0;
+	}
+	else {
+		br = (struct GMT_BR *)reader;
+		if (J->keep) {
+			GMT_get_br_bin (ind, br, J->levels, J->n_levels);
+			pscoast_keep_bin (J, (void *)br, out, A);
+			GMT_arena_reset (A);
+			GMT_free_br (br);
+			return;
+		}
+		if (J->lon == NULL && !J->hold && br->bin_npt && J->n_levels == 0) {
+			out->n = br->bin_npt[ind] + br->bin_nseg[ind];
+			return;
+		}
 		
-			GMT_free_br (&b);
-			for (k = 0; k < np; k++) {
-				GMT_free ((void *)p[k].lon);
-				GMT_free ((void *)p[k].lat);
-			}
-			GMT_free ((void *)p);
+		GMT_get_br_bin (ind, br, J->levels, J->n_levels);
+		
+		if (J->lon == NULL && !J->hold) {
+			for (i = n = 0; i < br->ns; i++) n += br->seg[i].n + 1;
+			out->n = n;
+			GMT_free_br (br);
+			return;
 		}
-		GMT_br_cleanup (&b);
 		
-		if (gmtdefs.verbose) fprintf (stderr, "\n");
+		np = (br->ns) ? GMT_assemble_br (br, J->shift, J->edge, &p, A) : 0;
+	}
+	
+	if (J->project)
+		pscoast_project_bin (J, out, p, np);
+	else if (J->hold)
+		pscoast_simplify_bin (J, out, p, np);
+	else if (np && J->single) {
+		flon = (float *)J->lon;
+		flat = (float *)J->lat;
+		for (i = 0, n = out->start; i < np; i++) {
+			flon[n] = flat[n] = (float)J->separator;
+			n++;
+			for (k = 0; k < p[i].n; k++, n++) {
+				flon[n] = (float)p[i].lon[k];
+				flat[n] = (float)p[i].lat[k];
+			}
+		}
 	}
+	else if (np) {
+		dlon = (double *)J->lon;
+		dlat = (double *)J->lat;
+		for (i = 0, n = out->start; i < np; i++) {
+			dlon[n] = dlat[n] = J->separator;
+			n++;
+			memcpy ((void *)&dlon[n], (void *)p[i].lon, (size_t)p[i].n * sizeof (double));
+			memcpy ((void *)&dlat[n], (void *)p[i].lat, (size_t)p[i].n * sizeof (double));
+			n += p[i].n;
+		}
+	}
+	GMT_arena_reset (A);	/* Instead of freeing every polygon */
 	
+	if (c)
+		GMT_free_shore (c);
+	else
+		GMT_free_br (br);
+}
+
+void pscoast_keep_bin (struct PSCOAST_JOB *J, void *reader, struct PSCOAST_BIN *out, struct GMT_ARENA *A)
+{
+	/* Copies the lines of a bin out of the arena: the open pieces that
+	 * GMT_merge_shore or GMT_stitch_lines join later, or the closed polygons
+	 * of the bin for each direction */
+
+	int i, dir, np;
+	struct POL *p;
+	struct GMT_SHORE *c;
+	struct GMT_BR *br;
+
+	out->p = (struct POL *)NULL;
+	out->np = 0;
+	for (dir = J->start_direction; ; dir += 2) {
+		if (J->kind != 'c') {
+			br = (struct GMT_BR *)reader;
+			np = (br->ns) ? GMT_assemble_br (br, J->shift, J->edge, &p, A) : 0;
+		}
+		else if (J->polygons && !J->merge) {
+			c = (struct GMT_SHORE *)reader;
+			np = GMT_assemble_shore (c, dir, J->min_level, TRUE, J->shift, J->west_border, J->east_border, &p, A);
+		}
+		else {
+			c = (struct GMT_SHORE *)reader;
+			np = (c->ns) ? GMT_assemble_shore (c, dir, J->min_level, FALSE, J->shift, J->west_border, J->east_border, &p, A) : 0;
+		}
+		if (np) out->p = (struct POL *) GMT_memory ((void *)out->p, (size_t)(out->np + np), sizeof (struct POL), "pscoast_keep_bin");
+		for (i = 0; i < np; i++, out->np++) {
+			out->p[out->np] = p[i];
+			out->p[out->np].lon = (double *) GMT_memory (VNULL, (size_t)p[i].n, sizeof (double), "pscoast_keep_bin");
+			out->p[out->np].lat = (double *) GMT_memory (VNULL, (size_t)p[i].n, sizeof (double), "pscoast_keep_bin");
+			memcpy ((void *)out->p[out->np].lon, (void *)p[i].lon, (size_t)p[i].n * sizeof (double));
+			memcpy ((void *)out->p[out->np].lat, (void *)p[i].lat, (size_t)p[i].n * sizeof (double));
+		}
+		if (!J->polygons || J->merge || dir >= J->stop_direction) break;	/* Pieces are the same for land and water */
+	}
+}
+
+struct POL *pscoast_gather (struct PSCOAST_JOB *J, int n_threads, int *n)
+{
+	/* Runs a job that keeps its bins and collects their lines in bin order,
+	 * however many threads did them.  Free with GMT_free_polygons */
+
+	int ind, n_all = 0;
+	struct POL *all = (struct POL *)NULL;
+
+	if (J->nb) {
+		J->out = (struct PSCOAST_BIN *) GMT_memory (VNULL, (size_t)J->nb, sizeof (struct PSCOAST_BIN), "pscoast_gather");
+		pscoast_run (J, n_threads);
+		for (ind = 0; ind < J->nb; ind++) n_all += J->out[ind].np;
+		all = (struct POL *) GMT_memory (VNULL, (size_t)n_all, sizeof (struct POL), "pscoast_gather");
+		for (ind = n_all = 0; ind < J->nb; ind++) {
+			if (J->out[ind].np == 0) continue;
+			memcpy ((void *)&all[n_all], (void *)J->out[ind].p, (size_t)J->out[ind].np * sizeof (struct POL));
+			n_all += J->out[ind].np;
+			GMT_free ((void *)J->out[ind].p);
+		}
+		GMT_free ((void *)J->out);
+		J->out = (struct PSCOAST_BIN *)NULL;
+	}
+	*n = n_all;
+	return (all);
+}
+
+void pscoast_project_bin (struct PSCOAST_JOB *J, struct PSCOAST_BIN *out, struct POL *p, int np)
+{
+	/* Projects the lines of a bin into out->x/y, in km like pscoast_forward.
+	 * Each line goes through the array kernel of the projection at once and
+	 * then through GMT_geo_to_xy_line_xy, which cuts it where it leaves the
+	 * map; the separator goes wherever the pen is lifted.  This is done
+	 * holding the projection lock, on the map of pscoast_xy set up again
+	 * (from GMT's setup cache) as other threads may have set up theirs since.
+	 * With a tolerance each piece is then simplified on the map, unlocked */
+	
+	int i, k, m, n = 0, n_alloc = 0, n_max = 0, n_runs = 0, n_run_alloc = 0, *run = (int *)NULL;
+	double *x = (double *)NULL, *y = (double *)NULL, *px, *py;
+	double x0, y0, sx, sy;
+	struct PSCOAST_CTX *C = J->C;
+	
+	for (i = 0; i < np; i++) if (p[i].n > n_max) n_max = p[i].n;
+	px = (double *) GMT_memory (VNULL, (size_t)n_max, sizeof (double), "pscoast_project_bin");
+	py = (double *) GMT_memory (VNULL, (size_t)n_max, sizeof (double), "pscoast_project_bin");
+	
+	GMT_project_lock ();
+	pscoast_project (C->jarg, C->map_w, C->map_e, C->map_s, C->map_n, C->rect);
+	x0 = project_info.x0;	sx = 0.001 * project_info.i_x_scale;
+	y0 = project_info.y0;	sy = 0.001 * project_info.i_y_scale;
+	for (i = 0; i < np; i++) {
+		GMT_geo_to_xy_array (p[i].lon, p[i].lat, px, py, p[i].n);
+		m = GMT_geo_to_xy_line_xy (p[i].lon, p[i].lat, px, py, p[i].n);
+		if (n + 2 * m > n_alloc) {	/* At worst a separator before every point */
+			n_alloc = n + 2 * m + GMT_CHUNK;
+			x = (double *) GMT_memory ((void *)x, (size_t)n_alloc, sizeof (double), "pscoast_project_bin");
+			y = (double *) GMT_memory ((void *)y, (size_t)n_alloc, sizeof (double), "pscoast_project_bin");
+		}
+		for (k = 0; k < m; k++) {
+			if (k == 0 || GMT_pen[k] == 3) {
+				x[n] = y[n] = J->separator;
+				n++;
+				if (n_runs == n_run_alloc) {
+					n_run_alloc += GMT_SMALL_CHUNK;
+					run = (int *) GMT_memory ((void *)run, (size_t)n_run_alloc, sizeof (int), "pscoast_project_bin");
+				}
+				run[n_runs++] = n;
+			}
+			x[n] = (GMT_x_plot[k] - x0) * sx;
+			y[n] = (GMT_y_plot[k] - y0) * sy;
+			n++;
+		}
+	}
+	GMT_project_unlock ();
+	
+	if (J->tolerance > 0.0) {	/* Simplify each run and move it up behind the one before */
+		for (i = m = 0; i < n_runs; i++) {
+			k = pscoast_thin (out, &x[run[i]], &y[run[i]], ((i + 1 < n_runs) ? run[i+1] - 1 : n) - run[i], J->tolerance, &x[run[i]], &y[run[i]]);
+			x[m] = y[m] = J->separator;
+			m++;
+			memmove ((void *)&x[m], (void *)&x[run[i]], (size_t)k * sizeof (double));
+			memmove ((void *)&y[m], (void *)&y[run[i]], (size_t)k * sizeof (double));
+			m += k;
+		}
+		n = m;
+	}
+	GMT_free ((void *)px);
+	GMT_free ((void *)py);
+	GMT_free ((void *)run);
+	out->x = x;
+	out->y = y;
+	out->n = n;
+}
+
+void pscoast_simplify_bin (struct PSCOAST_JOB *J, struct PSCOAST_BIN *out, struct POL *p, int np)
+{
+	/* Simplifies the lines of a bin into out->x/y, each after the separator.
+	 * The tolerance is in degrees, or in km on the map of pscoast_project if
+	 * J->measure.  Every line keeps its ends, so lines cut at bin edges still
+	 * meet there and closed lines stay closed */
+
+	int i, k, n, n_max;
+	double *x, *y, *px = (double *)NULL, *py = (double *)NULL;
+
+	for (i = n = n_max = 0; i < np; i++) {
+		n += p[i].n + 1;
+		if (p[i].n > n_max) n_max = p[i].n;
+	}
+	out->x = x = (double *) GMT_memory (VNULL, (size_t)n, sizeof (double), "pscoast_simplify_bin");
+	out->y = y = (double *) GMT_memory (VNULL, (size_t)n, sizeof (double), "pscoast_simplify_bin");
+	if (J->measure) {
+		px = (double *) GMT_memory (VNULL, (size_t)n_max, sizeof (double), "pscoast_simplify_bin");
+		py = (double *) GMT_memory (VNULL, (size_t)n_max, sizeof (double), "pscoast_simplify_bin");
+	}
+
+	for (i = n = 0; i < np; i++) {
+		x[n] = y[n] = J->separator;
+		n++;
+		memcpy ((void *)&x[n], (void *)p[i].lon, (size_t)p[i].n * sizeof (double));
+		memcpy ((void *)&y[n], (void *)p[i].lat, (size_t)p[i].n * sizeof (double));
+		if (!J->measure) {
+			n += pscoast_thin (out, &x[n], &y[n], p[i].n, J->tolerance, &x[n], &y[n]);
+			continue;
+		}
+		for (k = 0; k < p[i].n; k++) {
+			pscoast_forward (p[i].lon[k], p[i].lat[k], &px[k], &py[k]);
+			if (GMT_is_dnan (px[k] - px[k]) || GMT_is_dnan (py[k] - py[k])) break;	/* NaN or infinite */
+		}
+		if (k == p[i].n)
+			n += pscoast_thin (out, px, py, p[i].n, J->tolerance, &x[n], &y[n]);
+		else {	/* Not all on the map; left as it is */
+			out->n_in += p[i].n;
+			out->n_kept += p[i].n;
+			n += p[i].n;
+		}
+	}
+	out->n = n;
+	if (px) {
+		GMT_free ((void *)px);
+		GMT_free ((void *)py);
+	}
+}
+
+int pscoast_thin (struct PSCOAST_BIN *out, double *x, double *y, int n, double tolerance, double *u, double *v)
+{
+	/* Moves the points of u/v that GMT_simplify_line keeps for x/y to the
+	 * front and counts them in out.  x/y may be u/v.  Returns how many are kept */
+
+	int k, m;
+	char *keep;
+
+	if (n < 3) {
+		out->n_in += n;
+		out->n_kept += n;
+		return (n);
+	}
+	keep = (char *) GMT_memory (VNULL, (size_t)n, sizeof (char), "pscoast_thin");
+	GMT_simplify_line (x, y, n, tolerance, keep);
+	for (k = m = 0; k < n; k++) {
+		if (!keep[k]) continue;
+		u[m] = u[k];
+		v[m] = v[k];
+		m++;
+	}
+	GMT_free ((void *)keep);
+	out->n_in += n;
+	out->n_kept += m;
+	return (m);
+}
+
+void pscoast_simplify (void *ctx, double pixels, int width, BOOLEAN measure)
+{
+	/* Sets up the extractions with ctx to simplify lines to pixels on a map
+	 * width pixels wide: the region's, or with measure that of pscoast_project.
+	 * pixels = 0 turns it off */
+
+	struct PSCOAST_CTX *C;
+
+	C = (ctx) ? (struct PSCOAST_CTX *)ctx : &pscoast_default_ctx;
+	C->pixels = pixels;
+	C->width = width;
+	C->measure = measure;
+	if (measure) {
+		GMT_project_lock ();
+		pscoast_map_size (C);
+		GMT_project_unlock ();
+	}
+}
+
+void pscoast_simplify_stats (void *ctx, long stats[2])
+{
+	/* Points before and after simplifying in the last extraction with ctx */
+
+	struct PSCOAST_CTX *C;
+
+	C = (ctx) ? (struct PSCOAST_CTX *)ctx : &pscoast_default_ctx;
+	stats[0] = C->n_in;
+	stats[1] = C->n_kept;
+}
+
+void pscoast_put_xy (struct PSCOAST_JOB *J, struct PSCOAST_BIN *out)
+{
+	/* Copies the projected lines of a bin to their place in the output */
+	
+	int k;
+	float *fx, *fy;
+	
+	if (out->n && J->single) {
+		fx = (float *)J->lon + out->start;
+		fy = (float *)J->lat + out->start;
+		for (k = 0; k < out->n; k++) {
+			fx[k] = (float)out->x[k];
+			fy[k] = (float)out->y[k];
+		}
+	}
+	else if (out->n) {
+		memcpy ((void *)((double *)J->lon + out->start), (void *)out->x, (size_t)out->n * sizeof (double));
+		memcpy ((void *)((double *)J->lat + out->start), (void *)out->y, (size_t)out->n * sizeof (double));
+	}
+	if (out->x) {
+		GMT_free ((void *)out->x);
+		GMT_free ((void *)out->y);
+		out->x = out->y = (double *)NULL;
+	}
+}
+
+void pscoast_init (void)
+{
+	/* GMT's global defaults are set up once.  After that pscoast only reads them,
+	 * and everything that changes per request lives in a PSCOAST_CTX */
+
+	GMT_shore_lock ();
+	if (!pscoast_initialized) {
+		my_GMT_begin ();
+		pscoast_initialized = TRUE;
+	}
+	GMT_shore_unlock ();
+}
+
+int pscoast_project (char *jarg, double west, double east, double south, double north, BOOLEAN rect)
+{
+	/* Sets up the map projection given as to -J (e.g. "M1", "E-170/70/1") over
+	 * the region, for pscoast_forward and pscoast_inverse.  The scale part is
+	 * required by the syntax but not used.  With rect the region is the box
+	 * with lower left corner west/south and upper right corner east/north, as
+	 * for -R...r.  Maps set up before are restored from GMT's setup cache.
+	 * The map stays set up only while the caller holds pscoast_project_lock.
+	 * Returns TRUE if jarg is not a map projection */
+
+	int i, bad = FALSE;
+	char key[GMT_SETUP_KEY_LEN];
+
+	pscoast_init ();
+
+	if (jarg[0] == '-' && jarg[1] == 'J') jarg += 2;
+
+	GMT_project_lock ();
+	if (pscoast_ellipsoid < 0) pscoast_ellipsoid = gmtdefs.ellipsoid;
+	gmtdefs.ellipsoid = pscoast_ellipsoid;
+	project_info.region = !rect;
+	if (!GMT_setup_cache_get (key, jarg, west, east, south, north)) {
+		project_info.projection = -1;
+		project_info.gave_map_width = FALSE;
+		project_info.polar = project_info.north_pole = project_info.n_polar = project_info.s_polar = FALSE;	/* GMT_set_polar only sets them */
+		for (i = 0; i < 10; i++) project_info.pars[i] = 0.0;
+
+		if (GMT_map_getproject (jarg) || !MAPPING)
+			bad = TRUE;
+		else {
+			GMT_map_setup (west, east, south, north);
+			GMT_setup_cache_put (key);
+		}
+	}
+	GMT_project_unlock ();
+	return (bad);
+}
+
+void pscoast_project_lock (void)
+{
+	/* Held from pscoast_project until the last pscoast_forward or
+	 * pscoast_inverse on that map, so other threads cannot set up
+	 * theirs in between.  A thread may take it more than once */
+
+	GMT_project_lock ();
+}
+
+void pscoast_project_unlock (void)
+{
+	GMT_project_unlock ();
+}
+
+int pscoast_xy (double west, double east, double south, double north, char res, int rlevels[N_RLEVELS], int blevels[N_BLEVELS], int draw_coast, char *jarg, double map_w, double map_e, double map_s, double map_n, BOOLEAN rect, SV *x, SV *y, BOOLEAN single, double separator, void *ctx)
+{
+	/* Like pscoast_into, but the lines are projected as they come out of the
+	 * bins and clipped to the map set up by pscoast_project (jarg, map_w, ...).
+	 * x/y are in km like pscoast_forward.  The projection lock is only held
+	 * to set up the map and in pscoast_project_bin, so other threads can
+	 * read and simplify their bins meanwhile.  Returns TRUE if jarg is not a
+	 * map projection */
+	
+	struct PSCOAST_CTX *C;
+	
+	C = (ctx) ? (struct PSCOAST_CTX *)ctx : &pscoast_default_ctx;
+	GMT_project_lock ();
+	if (pscoast_project (jarg, map_w, map_e, map_s, map_n, rect)) {
+		GMT_project_unlock ();
+		return (TRUE);
+	}
+	pscoast_map_size (C);
+	GMT_project_unlock ();
+	
+	C->project = TRUE;
+	C->jarg = jarg;
+	C->map_w = map_w;	C->map_e = map_e;	C->map_s = map_s;	C->map_n = map_n;
+	C->rect = rect;
+	pscoast_into (west, east, south, north, res, rlevels, blevels, draw_coast, x, y, single, separator, ctx, 1);
+	C->project = FALSE;
+	C->jarg = (char *)NULL;
+	return (FALSE);
+}
+
+void pscoast_map_size (struct PSCOAST_CTX *C)
+{
+	/* Copies what pscoast_begin needs of the map just set up into C, so the
+	 * tolerance does not depend on what other threads set up since.  Callers
+	 * hold the projection lock */
+
+	C->map_km = (project_info.xmax - project_info.xmin) * 0.001 * project_info.i_x_scale;
+	C->map_m_pr_deg = project_info.M_PR_DEG;
+}
+
+void pscoast_forward (double lon, double lat, double *x, double *y)
+{
+	/* lon/lat to x/y in km on the plane of the projection, i.e. before GMT
+	 * scales it to the plot.  Callers hold pscoast_project_lock */
+
+	(*GMT_forward) (lon, lat, x, y);
+	(*x) *= 0.001;
+	(*y) *= 0.001;
+}
+
+void pscoast_inverse (double x, double y, double *lon, double *lat)
+{
+	/* Inverse of pscoast_forward */
+
+	(*GMT_inverse) (lon, lat, x * 1000.0, y * 1000.0);
+}
+
+void pscoast_forward_array (SV *lon, SV *lat, SV *x, SV *y)
+{
+	/* pscoast_forward for the doubles of lon/lat, into those of x/y, through
+	 * the array kernel of the projection.  Callers hold pscoast_project_lock */
+	dTHX;
+	int i, n;
+	double *px, *py;
+
+	n = (int)(SvCUR (lon) / sizeof (double));
+	px = (double *)SvPVX (x);
+	py = (double *)SvPVX (y);
+	GMT_forward_array ((double *)SvPVX (lon), (double *)SvPVX (lat), px, py, n);
+	for (i = 0; i < n; i++) {
+		px[i] *= 0.001;
+		py[i] *= 0.001;
+	}
+}
+
+void pscoast_inverse_array (SV *x, SV *y, SV *lon, SV *lat)
+{
+	/* pscoast_inverse for the doubles of x/y, into those of lon/lat, with
+	 * GMT_inverse_array.  Callers hold pscoast_project_lock */
+	dTHX;
+	int i, n;
+	double *px, *py, *plon, *plat;
+
+	n = (int)(SvCUR (x) / sizeof (double));
+	px = (double *)SvPVX (x);	plon = (double *)SvPVX (lon);
+	py = (double *)SvPVX (y);	plat = (double *)SvPVX (lat);
+	for (i = 0; i < n; i++) {
+		plon[i] = px[i] * 1000.0;
+		plat[i] = py[i] * 1000.0;
+	}
+	GMT_inverse_array (plon, plat, plon, plat, (char *)NULL, n);
+}
+
+int pscoast_fast_trig (int on)
+{
+	/* Sets (on >= 0) whether the next pscoast_project uses fast trig; returns the previous setting */
+	int old;
+
+	GMT_project_lock ();
+	old = GMT_fast_trig;
+	if (on >= 0) GMT_fast_trig = on;
+	GMT_project_unlock ();
+	return (old);
+}
+
+void pscoast_lat_swap (SV *lat, int itype, BOOLEAN table)
+{
+	/* Converts the doubles in lat, in place, from one kind of latitude to another
+	 * on the ellipsoid of pscoast_project.  The current projection is left as it was */
+	dTHX;
+	int old;
+
+	pscoast_init ();
+
+	GMT_project_lock ();
+	if (pscoast_ellipsoid < 0) pscoast_ellipsoid = gmtdefs.ellipsoid;
+	old = gmtdefs.ellipsoid;
+	gmtdefs.ellipsoid = pscoast_ellipsoid;
+	GMT_lat_swap_init ();
+	GMT_lat_swap_array ((double *)SvPVX (lat), (double *)SvPVX (lat), (int)(SvCUR (lat) / sizeof (double)), itype, table);
+	gmtdefs.ellipsoid = old;
+	GMT_lat_swap_init ();
+	GMT_project_unlock ();
+}
+
+int pscoast_inverse_grid (double x0, double dx, int nx, double y0, double dy, int ny, SV *lon, SV *lat, SV *ok, int n_threads)
+{
+	/* Inverse projects the nx by ny grid of nodes x0 + i * dx, y0 + j * dy (km)
+	 * through the projection of pscoast_project, into the doubles of lon and
+	 * lat and the chars of ok (1 where the inverse converged), row by row.
+	 * Rows are handed out to n_threads workers, which use the map while this
+	 * thread holds the projection lock.  Returns the number of nodes that did
+	 * not converge */
+
+	dTHX;
+	int j;
+	double *x, *y;
+	struct PSCOAST_GRID G;
+#ifdef GMT_THREADS
+	int t;
+	pthread_t *thread;
+#endif
+
+	G.x0 = x0;	G.dx = dx;	G.nx = nx;
+	G.y0 = y0;	G.dy = dy;	G.ny = ny;
+	G.next = G.n_bad = 0;
+	G.lon = (double *)SvPVX (lon);
+	G.lat = (double *)SvPVX (lat);
+	G.ok = (ok && SvOK (ok)) ? (char *)SvPVX (ok) : NULL;
+
+	GMT_project_lock ();
+#ifdef GMT_THREADS
+	if (n_threads > ny) n_threads = ny;
+	if (n_threads > 1) {
+		thread = (pthread_t *) GMT_memory (VNULL, (size_t)n_threads, sizeof (pthread_t), "pscoast_inverse_grid");
+		pthread_mutex_init (&G.lock, NULL);
+
+		for (t = 0; t < n_threads; t++) {
+			if (pthread_create (&thread[t], NULL, pscoast_grid_worker, (void *)&G)) {
+				fprintf (stderr, "%s: Could not start worker thread\n", GMT_program);
+				break;
+			}
+		}
+		if (t == 0) pscoast_grid_worker ((void *)&G);	/* Do it ourselves then */
+		while (t > 0) pthread_join (thread[--t], NULL);
+
+		pthread_mutex_destroy (&G.lock);
+		GMT_free ((void *)thread);
+		GMT_project_unlock ();
+		return (G.n_bad);
+	}
+#endif
+	x = (double *) GMT_memory (VNULL, (size_t)nx, sizeof (double), "pscoast_inverse_grid");
+	y = (double *) GMT_memory (VNULL, (size_t)nx, sizeof (double), "pscoast_inverse_grid");
+	for (j = 0; j < ny; j++) G.n_bad += pscoast_inverse_row (&G, j, x, y);
+	GMT_free ((void *)x);
+	GMT_free ((void *)y);
+	GMT_project_unlock ();
+	return (G.n_bad);
+}
+
+int pscoast_inverse_row (struct PSCOAST_GRID *G, int j, double *x, double *y)
+{
+	/* Inverse projects row j of G, with x and y as scratch for nx values.
+	 * The nodes go along the row, so GMT_inverse_array can warm start.
+	 * Returns the number of nodes that did not converge */
+
+	int i;
+	size_t k = (size_t)j * (size_t)G->nx;
+
+	for (i = 0; i < G->nx; i++) {
+		x[i] = (G->x0 + i * G->dx) * 1000.0;
+		y[i] = (G->y0 + j * G->dy) * 1000.0;
+	}
+	return (GMT_inverse_array (x, y, &G->lon[k], &G->lat[k], (G->ok) ? &G->ok[k] : NULL, G->nx));
+}
+
+#ifdef GMT_THREADS
+void *pscoast_grid_worker (void *arg)
+{
+	/* Takes rows off the grid until none are left */
+
+	int j, n_bad = 0;
+	double *x, *y;
+	struct PSCOAST_GRID *G;
+
+	G = (struct PSCOAST_GRID *)arg;
+	x = (double *) GMT_memory (VNULL, (size_t)G->nx, sizeof (double), "pscoast_grid_worker");
+	y = (double *) GMT_memory (VNULL, (size_t)G->nx, sizeof (double), "pscoast_grid_worker");
+	for (;;) {
+		pthread_mutex_lock (&G->lock);
+		j = G->next++;
+		pthread_mutex_unlock (&G->lock);
+		if (j >= G->ny) break;
+		n_bad += pscoast_inverse_row (G, j, x, y);
+	}
+	GMT_free ((void *)x);
+	GMT_free ((void *)y);
+
+	pthread_mutex_lock (&G->lock);
+	G->n_bad += n_bad;
+	pthread_mutex_unlock (&G->lock);
+	return (NULL);
+}
+#endif
+
+void pscoast_arena_done (struct GMT_ARENA *A)
+{
+	/* Adds the counts of an arena to pscoast_arena_stats and frees it */
+
+	GMT_shore_lock ();
+	pscoast_arena_stats[0] += A->n_alloc;
+	pscoast_arena_stats[1] += A->n_block;
+	pscoast_arena_stats[2] += A->n_reset;
+	GMT_shore_unlock ();
+	GMT_arena_free (A);
+}
+
+void pscoast_arena_stats_get (long stats[3])
+{
+	/* Pieces handed out, blocks obtained with GMT_memory and bins reset
+	 * by the arenas of all extractions so far */
+
+	GMT_shore_lock ();
+	memcpy ((void *)stats, (void *)pscoast_arena_stats, 3 * sizeof (long));
+	GMT_shore_unlock ();
+}
+
+void *pscoast_context_new (void)
+{
+	return (GMT_memory (VNULL, (size_t)1, sizeof (struct PSCOAST_CTX), "pscoast_context_new"));
+}
+
+void pscoast_context_free (void *ctx)
+{
+	if (ctx) GMT_free (ctx);
 }
 
 int my_GMT_begin ()
@@ -6,7 +6,7 @@
 # Change 1..1 below to 1..last_test_to_print .
 # (It may become useful if the test is moved to ./t subdirectory.)
 
-BEGIN { $| = 1; print "1..4\n"; }
+BEGIN { $| = 1; print "1..25\n"; }
 END {print "not ok 1\n" unless $loaded;}
 use PDL;
 use PDL::Graphics::PGPLOT;
@@ -68,6 +68,239 @@ my $tol = 1e-4;
 my $ok = (sum(abs($lat100 - $lat->slice("0:100"))) < $tol) ? "ok 4" : "not ok 4";
 print "$ok\n";
 
+# A second fetch of the same area must come out of the bin cache unchanged
+my ($hits0) = PDL::Graphics::PGPLOT::Map::cache_stats();
+my ($lon2, $lat2) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'low',
+                                              BOX        => \@bounds,
+                                              BOUNDARIES => [1],
+                                              COASTS     => 1,
+                                              SEPARATOR  => -99999});
+my ($hits1) = PDL::Graphics::PGPLOT::Map::cache_stats();
+my $ok = ($hits1 > $hits0 && $lat2->nelem == $lat->nelem &&
+          sum(abs($lat2 - $lat)) < $tol) ? "ok 5" : "not ok 5";
+print "$ok\n";
+
+# The compact binary database must give the same result as the netCDF one
+my ($lonc, $latc) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'crude'});
+PDL::Graphics::PGPLOT::Map::cache_flush();
+my $err = PDL::Graphics::PGPLOT::Map::shore_convert('c', 'c', 'binned_GSHHS_c.bin');
+my ($lonb, $latb) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'crude'});
+PDL::Graphics::PGPLOT::Map::cache_flush();
+unlink 'binned_GSHHS_c.bin';
+my $ok = ($err == 0 && $latb->nelem == $latc->nelem &&
+          sum(abs($latb - $latc)) + sum(abs($lonb - $lonc)) < $tol) ? "ok 6" : "not ok 6";
+print "$ok\n";
+
+# An explicit context and several workers must give the same result as before
+my $ctx = PDL::Graphics::PGPLOT::Map::context_new();
+my ($lonx, $latx) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'crude', CONTEXT => $ctx, THREADS => 4});
+PDL::Graphics::PGPLOT::Map::context_free($ctx);
+my $ok = ($latx->nelem == $latc->nelem &&
+          sum(abs($latx - $latc)) + sum(abs($lonx - $lonc)) < $tol) ? "ok 7" : "not ok 7";
+print "$ok\n";
+
+# Float output must be the double output rounded, separators included
+my ($lonf, $latf) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'crude', TYPE => float});
+my $ok = ($latf->get_datatype == $PDL_F && $latf->nelem == $latc->nelem &&
+          sum(abs($latf - float($latc))) + sum(abs($lonf - float($lonc))) == 0) ? "ok 8" : "not ok 8";
+print "$ok\n";
+
+# Chunks from the iterator must add up to a single fetch
+my $it = PDL::Graphics::PGPLOT::Map::fetch_iter({RESOLUTION => 'crude'});
+my (@loni, @lati);
+while (my ($lon1, $lat1) = $it->next(2000)) {
+  push (@loni, $lon1);
+  push (@lati, $lat1);
+}
+my ($loni, $lati) = ($loni[0], $lati[0]);
+for (my $i = 1; $i < @loni; $i++) {
+  $loni = $loni->append($loni[$i]);
+  $lati = $lati->append($lati[$i]);
+}
+my $ok = (@loni > 1 && $lati->nelem == $latc->nelem &&
+          sum(abs($lati - $latc)) + sum(abs($loni - $lonc)) < $tol) ? "ok 9" : "not ok 9";
+print "$ok\n";
+
+# The bin index must not change what is extracted
+my $err = PDL::Graphics::PGPLOT::Map::shore_index('c', 'c', 'binned_GSHHS_c.idx');
+PDL::Graphics::PGPLOT::Map::cache_flush();
+my ($loni, $lati) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'crude'});
+PDL::Graphics::PGPLOT::Map::cache_flush();
+unlink 'binned_GSHHS_c.idx';
+my $ok = ($err == 0 && $lati->nelem == $latc->nelem &&
+          sum(abs($lati - $latc)) + sum(abs($loni - $lonc)) < $tol) ? "ok 10" : "not ok 10";
+print "$ok\n";
+
+# A one degree tolerance is met by the crude data base
+my ($loni, $lati, $res) = PDL::Graphics::PGPLOT::Map::fetch({RESOLUTION => 'auto', TOLERANCE => 1});
+my $ok = ($res eq 'c' && $lati->nelem == $latc->nelem &&
+          sum(abs($lati - $latc)) + sum(abs($loni - $lonc)) < $tol) ? "ok 11" : "not ok 11";
+print "$ok\n";
+
+# Compiled projection: the center goes to 0,0, the inverse gets back, bad stays bad
+my $plon = pdl (-170, -10, 100, 0)->setbadat(3);
+my $plat = pdl (  70,  20, -45, 0);
+my ($px, $py) = PDL::Graphics::PGPLOT::Map::gmt_project ($plon, $plat, 'E-170/70/1');
+my ($qlon, $qlat) = PDL::Graphics::PGPLOT::Map::gmt_unproject ($px, $py, 'E-170/70/1');
+my $ok = (abs($px->at(0)) + abs($py->at(0)) < 1e-6 && $px->isbad->at(3) &&
+          sum(abs($qlon - $plon)) + sum(abs($qlat - $plat)) < 1e-6) ? "ok 12" : "not ok 12";
+print "$ok\n";
+
+# Fused fetch and project: everything lands inside the Mercator map
+my ($fx, $fy) = PDL::Graphics::PGPLOT::Map::fetch_xy ({JPROJ => 'M1', MAP => [-20, 40, 30, 70],
+                                                       BOX => [-40, 60, 20, 80], SEPARATOR => -99999});
+my $fm = $fx != -99999;
+my ($flon, $flat) = PDL::Graphics::PGPLOT::Map::gmt_unproject ($fx->where($fm), $fy->where($fm), 'M1', -20, 40, 30, 70);
+my $ok = ($flon->nelem > 0 && $flon->min > -20.001 && $flon->max < 40.001 &&
+          $flat->min > 29.999 && $flat->max < 70.001) ? "ok 13" : "not ok 13";
+print "$ok\n";
+
+# Layer cache: a layer written to the directory is read back by a fresh cache
+my $dir = "/tmp/pgplot_map_layers.$$";
+mkdir ($dir);
+PDL::Graphics::PGPLOT::Map::layer_cache_dir ($dir);
+my @made = PDL::Graphics::PGPLOT::Map::_layer (1, 'test layer', sub { (sequence(5) * 1.5, float(2, -99999)) });
+PDL::Graphics::PGPLOT::Map::layer_cache_flush ();
+my @read = PDL::Graphics::PGPLOT::Map::_layer (1, 'test layer', sub { die "layer not cached" });
+my @stats = PDL::Graphics::PGPLOT::Map::layer_cache_stats ();
+my $ok = (@read == 2 && $stats[1] == 1 && $read[1]->get_datatype == $PDL_F &&
+          sum(abs($read[0] - $made[0])) + sum(abs($read[1] - $made[1])) == 0) ? "ok 14" : "not ok 14";
+print "$ok\n";
+unlink (glob ("$dir/*"));
+rmdir ($dir);
+PDL::Graphics::PGPLOT::Map::layer_cache_dir (undef);
+
+# Fast trigonometry stays within 1e-11 of the radius of the exact projection.  On the
+# default (WGS-84) ellipsoid stereographic, Lambert and Mollweide go through the lat_swap table
+my $glon = sequence(37) * 10 - 180;
+my $glat = sequence(37) * 5 - 90;
+my $ok = "ok 15";
+my $ff = sequence(1000) / 999;
+foreach my $f (['E-170/70/1'], ['G-30/40/1', -60, 0, 10, 70], ['S-30/40/1', -60, 0, 10, 70],
+               ['A-30/40/1', -60, 0, 10, 70], ['W0/1', -180, 180, -89, 89]) {
+  my ($jproj, @box) = @$f;
+  my ($w, $e, $s, $n) = @box ? @box : (-180, 180, -90, 90);
+  my $flon = $w + ($e - $w) * $ff;
+  my $flat = $s + ($n - $s) * ($ff * 13 - floor($ff * 13));
+  my ($ex, $ey) = PDL::Graphics::PGPLOT::Map::gmt_project ($flon, $flat, $jproj, @box);
+  PDL::Graphics::PGPLOT::Map::fast_trig (1);
+  my ($tx, $ty) = PDL::Graphics::PGPLOT::Map::gmt_project ($flon, $flat, $jproj, @box);
+  PDL::Graphics::PGPLOT::Map::fast_trig (0);
+  $ok = "not ok 15" unless (max(abs($tx - $ex)) < 6371e-11 && max(abs($ty - $ey)) < 6371e-11);
+}
+print "$ok\n";
+
+# Latitude conversion: the lookup table agrees with the series it is made from
+my $llat = sequence(1801) * 0.1 - 90;
+my $ok = "ok 16";
+foreach my $kind ('G2A', 'A2G', 'G2C', 'C2G', 'G2M', 'M2G') {
+  my $series = PDL::Graphics::PGPLOT::Map::lat_swap ($llat, $kind);
+  my $table  = PDL::Graphics::PGPLOT::Map::lat_swap ($llat, $kind, 1);
+  $ok = "not ok 16" unless (max(abs($series - $llat)) > 0.05 && max(abs($table - $series)) < 1e-12);
+}
+print "$ok\n";
+
+# Great circle distances: known values, one point to many as pairs too, threading, and the matrix
+my ($gd, $ga) = PDL::Graphics::PGPLOT::Map::gc_dist (pdl(0), pdl(0), pdl(0, 90, -90, 180), pdl(10, 0, 0, 0));
+my ($md, $ma) = PDL::Graphics::PGPLOT::Map::gc_dist_matrix (pdl(0, 10), pdl(0, 20), pdl(0, 90, -90, 180), pdl(10, 0, 0, 0));
+my ($td, $ta) = PDL::Graphics::PGPLOT::Map::gc_dist (pdl(0, 10)->dummy(0, 4), pdl(0, 20)->dummy(0, 4),
+                                                     pdl(0, 90, -90, 180), pdl(10, 0, 0, 0));
+my ($pd, $pa) = PDL::Graphics::PGPLOT::Map::gc_dist_pairs (pdl(0), pdl(0), pdl(0, 90, -90, 180), pdl(10, 0, 0, 0));
+my $ok = (max(abs($gd - pdl(10, 90, 90, 180))) < 1e-12 && max(abs($ga->slice('0:2') - pdl(0, 90, 270))) < 1e-12 &&
+          max(abs($pd - $gd)) < 1e-12 && max(abs($pa - $ga)) < 1e-12 &&
+          max(abs($md - $td)) < 1e-9 && max(abs($ma - $ta)) < 1e-9) ? "ok 17" : "not ok 17";
+print "$ok\n";
+
+# Grid inverse: warm started Lambert conic agrees with the inverse of each node
+my @lbox = (-130, -60, 20, 55);
+my ($ulon, $ulat, $uok) = PDL::Graphics::PGPLOT::Map::gmt_unproject_grid ([-1500, 1500, 31], [-1000, 1000, 21],
+                                                                          'l-100/40/30/50/1:10000000', @lbox);
+my $ux = (sequence(31) * 100 - 1500)->dummy(1, 21);
+my $uy = (sequence(21) * 100 - 1000)->dummy(0, 31);
+my ($elon, $elat) = PDL::Graphics::PGPLOT::Map::gmt_unproject ($ux, $uy, 'l-100/40/30/50/1:10000000', @lbox);
+my $ok = ($uok->min == 1 && max(abs($ulon - $elon)) < 1e-8 && max(abs($ulat - $elat)) < 1e-8) ? "ok 18" : "not ok 18";
+print "$ok\n";
+
+# Setting up a projection seen before restores it from the setup cache
+PDL::Graphics::PGPLOT::Map::setup_cache_flush ();
+my ($sx0, $sy0) = PDL::Graphics::PGPLOT::Map::gmt_project ($glon, $glat, 'E-170/70/1');
+my ($sx1, $sy1) = PDL::Graphics::PGPLOT::Map::gmt_project ($glon, $glat, 'S0/90/1', -180, 180, 0, 90);
+my ($sx2, $sy2) = PDL::Graphics::PGPLOT::Map::gmt_project ($glon, $glat, 'E-170/70/1');
+my @setup = PDL::Graphics::PGPLOT::Map::setup_cache_stats ();
+my $ok = ($setup[0] == 1 && $setup[1] == 2 && $setup[2] == 2 &&
+          sum(abs($sx2 - $sx0)) == 0 && sum(abs($sy2 - $sy0)) == 0) ? "ok 19" : "not ok 19";
+print "$ok\n";
+
+# The polygons of the bins fetched so far came out of a few arena blocks
+my ($pieces, $blocks, $bins) = PDL::Graphics::PGPLOT::Map::arena_stats ();
+my $ok = ($bins > 0 && $pieces > $bins && $blocks * 10 < $pieces) ? "ok 20" : "not ok 20";
+print "$ok\n";
+
+# Land polygons: closed rings in order of level, the continents whole once the bins are merged
+my ($plon, $plat, $pres, $plev, $pin) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude', POLYGONS => 'land'});
+my (undef, undef, undef, $blev, $bin) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude', POLYGONS => 'land', MERGE => 0});
+my $first = which ($plon == -999) + 1;
+my $last  = append ($first->slice('1:-1') - 2, pdl([$plon->nelem - 1]));
+my $ok = ($plev->nelem == $first->nelem && $plev->min == 1 && min ($plev->slice('1:-1') - $plev->slice('0:-2')) >= 0 &&
+          sum(abs($plon->index($first) - $plon->index($last))) == 0 && sum(abs($plat->index($first) - $plat->index($last))) == 0 &&
+          sum(($pin == 0) & ($plev == 1)) * 10 < sum(($bin == 0) & ($blev == 1))) ? "ok 21" : "not ok 21";
+print "$ok\n";
+
+# Stitched lines: the pieces of all bins joined across bin edges, the same again from the cache
+my ($ulon) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude'});
+my ($slon, $slat, $sres, $spieces, $slines) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude', STITCH => 1});
+my ($clon, $clat, $cres, $cpieces, $clines) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude', STITCH => 1});
+my $ok = ($spieces == sum($ulon == -999) && $slines == sum($slon == -999) && $slines < $spieces &&
+          $cpieces == $spieces && $clines == $slines && sum(abs($clon - $slon)) == 0) ? "ok 22" : "not ok 22";
+print "$ok\n";
+
+# Simplified to a pixel of a 500 pixel wide map: fewer points, the same lines
+my ($dlon) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude', SIMPLIFY => 1, PIXELS => 500});
+my ($npts, $nkept) = PDL::Graphics::PGPLOT::Map::simplify_stats ();
+my $ok = (sum($dlon == -999) == sum($ulon == -999) && $npts == sum($ulon != -999) &&
+          $nkept == sum($dlon != -999) && $nkept < $npts) ? "ok 23" : "not ok 23";
+print "$ok\n";
+
+# Point ranks: the same lines from fewer points read, and nothing changes without SIMPLIFY
+my $err = PDL::Graphics::PGPLOT::Map::shore_rank('c', 'c', 'binned_GSHHS_c.rnk');
+PDL::Graphics::PGPLOT::Map::cache_flush();
+my ($rlon) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude', SIMPLIFY => 1, PIXELS => 500});
+my ($rpts, $rkept) = PDL::Graphics::PGPLOT::Map::simplify_stats ();
+my ($alon) = PDL::Graphics::PGPLOT::Map::fetch ({RESOLUTION => 'crude'});
+PDL::Graphics::PGPLOT::Map::cache_flush();
+unlink 'binned_GSHHS_c.rnk';
+my $ok = ($err == 0 && sum($rlon == -999) == sum($ulon == -999) && $rpts < $npts && $rkept == sum($rlon != -999) &&
+          $alon->nelem == $ulon->nelem && sum(abs($alon - $ulon)) == 0) ? "ok 24" : "not ok 24";
+print "$ok\n";
+
+# Array kernels: gmt_project and gmt_unproject agree with gmt_forward and gmt_inverse point by point
+my @kernels = (['Q0/1'], ['E-170/70/1'], ['G-30/40/1', -60, 0, 10, 70], ['S-30/40/1', -60, 0, 10, 70],
+               ['A-30/40/1', -60, 0, 10, 70], ['W0/1'], ['J0/1', -180, 180, -80, 80], ['T-30/1', -40, -20, 30, 60],
+               ['l-100/40/30/50/1:10000000', @lbox], ['b-100/40/30/50/1:10000000', @lbox],
+               ['C-30/40/1', -40, -20, 30, 50], ['M1', -180, 180, -80, 80], ['I0/1'], ['Y0/45/1']);
+my $kf = sequence(500) / 499;
+my $ok = "ok 25";
+foreach my $fast (0, 1) {
+  PDL::Graphics::PGPLOT::Map::fast_trig ($fast);
+  foreach my $k (@kernels) {
+    my ($jproj, @box) = @$k;
+    my ($w, $e, $s, $n) = @box ? @box : (-180, 180, -90, 90);
+    my $klon = $w + ($e - $w) * $kf;
+    my $klat = $s + ($n - $s) * ($kf * 7 - floor($kf * 7));
+    my ($ax, $ay) = PDL::Graphics::PGPLOT::Map::gmt_project ($klon, $klat, $jproj, @box);
+    my ($alon, $alat) = PDL::Graphics::PGPLOT::Map::gmt_unproject ($ax, $ay, $jproj, @box);
+    PDL::Graphics::PGPLOT::Map::project_lock ();
+    PDL::Graphics::PGPLOT::Map::_project_setup ($jproj, @box);
+    my ($sx, $sy) = PDL::Graphics::PGPLOT::Map::gmt_forward ($klon, $klat);
+    my ($slon, $slat) = PDL::Graphics::PGPLOT::Map::gmt_inverse ($ax, $ay);
+    PDL::Graphics::PGPLOT::Map::project_unlock ();
+    $ok = "not ok 25" unless (max(abs($ax - $sx)) < 1e-9 && max(abs($ay - $sy)) < 1e-9 &&
+                              max(abs($alon - $slon)) < 1e-8 && max(abs($alat - $slat)) < 1e-8);
+  }
+}
+PDL::Graphics::PGPLOT::Map::fast_trig (0);
+print "$ok\n";
+
 # begin PGPLOT section
 print "You will need PGPLOT from here on out...\n";
 print "The GIF driver must be installed.  Verify that files testmap1.gif through testmap7.gif\n";